@@ -0,0 +1,124 @@
+/**
+ * @file   messenger_cache.hpp
+ * @brief  Bounded LRU cache of decoded messages placed in front of messenger::parse_buff.
+ *
+ * @detail Relays receive the same raw buffer (same sender, same text) over many links. Instead of
+ *	parsing every copy again, the decoded message is remembered under a hash of the raw bytes and
+ *	returned on the next lookup. Entries are compared byte by byte on lookup, so a hash collision
+ *	never yields a foreign message.
+ *
+ *	The cache is split into shards, each with its own lock and LRU list, so that concurrent
+ *	receivers rarely contend on the same mutex.
+ */
+#ifndef MESSENGER_CACHE_HPP
+#define MESSENGER_CACHE_HPP
+
+#include <stdint.h>
+#include <cstddef>
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "task1_messenger.hpp"
+
+namespace messenger
+{
+
+/**
+	* Helper type to represent cache usage counters
+	*/
+struct cache_stats_t
+{
+	uint64_t hits;		/**< lookups answered from the cache */
+	uint64_t misses;	/**< lookups that required parse_buff */
+};
+
+
+/**
+	* Sharded LRU cache of parse_buff results
+	*
+	* @sample
+	*
+	* messenger::parse_cache cache(1024);
+	*
+	* // first call parses the buffer, subsequent calls with the same bytes are a hash lookup
+	* messenger::msg_t msg = cache.parse(buff);
+	*/
+class parse_cache
+{
+public:
+	/**
+	* @param capacity maximum number of cached messages, split between shards (they differ by one entry at most)
+	* @param shards_count number of independently locked shards
+	*
+	* @note throws std::invalid_argument if capacity or shards_count is zero
+	*/
+	parse_cache(size_t capacity, size_t shards_count = 8);
+
+	parse_cache(const parse_cache&) = delete;
+	parse_cache& operator=(const parse_cache&) = delete;
+
+	/**
+	* Parse specified raw message buffer, reusing a previously decoded result if possible
+	*
+	* @param buff raw message buffer, left unmodified
+	* @return parsed message
+	*
+	* @note errors of parse_buff are propagated and the failed buffer is not cached
+	*/
+	msg_t parse(const std::vector<uint8_t>& buff);
+
+	cache_stats_t stats() const;
+
+	size_t size() const;
+
+	void clear();
+
+private:
+	struct key_t
+	{
+		size_t hash;
+		std::string_view bytes;
+
+		bool operator==(const key_t& other) const
+		{
+			return bytes == other.bytes;
+		}
+	};
+
+	struct key_hash_t
+	{
+		size_t operator()(const key_t& key) const
+		{
+			return key.hash;
+		}
+	};
+
+	struct entry_t
+	{
+		std::vector<uint8_t> raw;	/**< owns the bytes referenced by the index key */
+		msg_t msg;
+	};
+
+	struct shard_t
+	{
+		mutable std::mutex lock;
+		size_t capacity;
+		std::list<entry_t> lru;		/**< most recently used entry first */
+		std::unordered_map<key_t, std::list<entry_t>::iterator, key_hash_t> index;
+	};
+
+	static key_t make_key(const std::vector<uint8_t>& buff);
+
+	std::vector<shard_t> shards;
+
+	std::atomic<uint64_t> hits;
+	std::atomic<uint64_t> misses;
+};
+
+}	// namespace messenger
+
+#endif // !MESSENGER_CACHE_HPP
@@ -0,0 +1,89 @@
+/**
+ * @file   messenger_filter.hpp
+ * @brief  Decoding of the messages of selected senders only.
+ *
+ * @detail The sender name is stored in the first packet of every buffer, right after the 2 byte header.
+ *	parse_filtered reads only these bytes and looks the name up in a precompiled sender_filter; buffers
+ *	of other senders are dropped before their CRC4 is calculated or their text is copied.
+ */
+#ifndef MESSENGER_FILTER_HPP
+#define MESSENGER_FILTER_HPP
+
+#include <stdint.h>
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "task1_messenger.hpp"
+
+namespace messenger
+{
+
+/**
+	* Precompiled set of sender names
+	*
+	* @detail A name fits into 16 bytes together with its length (NAME_LEN is at most 15), so every name is
+	*	packed into two 64 bit words and kept in an open addressing table. A lookup is one hash and
+	*	two word compares, no string comparison.
+	*/
+class sender_filter
+{
+public:
+	/**
+	* @param senders names to accept
+	*
+	* @note Empty names and names longer than 15 characters throw std::length_error, as in make_buff
+	*/
+	sender_filter(const std::vector<std::string>& senders);
+
+	bool contains(std::string_view name) const;
+
+	size_t size() const
+	{
+		return count;
+	}
+
+private:
+	struct key_t
+	{
+		uint64_t lo;
+		uint64_t hi;	/**< the last byte holds the name length, 0 marks an empty slot */
+	};
+
+	static key_t pack(std::string_view name);
+
+	size_t slot_of(const key_t& key) const;
+
+	std::vector<key_t> slots;
+	size_t mask;
+	size_t count;
+};
+
+
+/**
+* Parse specified raw message buffer if its sender is accepted by filter
+*
+* @param buff raw message buffer, left unmodified
+* @param filter accepted senders
+* @return parsed message, or nothing if the sender is not accepted
+*
+* @note Accepted buffers are verified the same way as in parse_buff; other buffers are dropped after
+* their first FLAG is checked.
+*/
+std::optional<msg_t> parse_filtered(std::span<const uint8_t> buff, const sender_filter& filter);
+
+
+/**
+* Parse the buffers of the accepted senders
+*
+* @param buffs raw message buffers, one message per buffer
+* @return parsed messages, in the order of buffs
+*/
+std::vector<msg_t> parse_filtered(const std::vector<std::vector<uint8_t>>& buffs, const sender_filter& filter);
+
+}	// namespace messenger
+
+#endif // !MESSENGER_FILTER_HPP
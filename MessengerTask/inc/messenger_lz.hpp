@@ -0,0 +1,74 @@
+/**
+ * @file   messenger_lz.hpp
+ * @brief  Small LZ77 style codec used to shrink long message texts before they are split into packets.
+ *
+ * @detail Compressed block layout:
+ *
+ *	+----------------+-----------+-----------+-- ... --+-----------------+
+ *	|  TEXT_LEN      | SEQUENCE  | SEQUENCE  |         | LAST SEQUENCE   |
+ *	+----------------+-----------+-----------+-- ... --+-----------------+
+ *
+ *	TEXT_LEN	- [varint]	- size of the original text, 7 bits per byte, least significant group first;
+ *	SEQUENCE	- TOKEN, [LIT_LEN+], LITERALS, OFFSET, [MATCH_LEN+]:
+ *		TOKEN		- [1 byte]	- high nibble: literals count, low nibble: match length - 4 (15 means "continued");
+ *		LIT_LEN+	- continuation of literals count: bytes added up while they are equal to 255;
+ *		LITERALS	- bytes copied as is;
+ *		OFFSET		- [2 bytes]	- little endian distance back to the match start, [1:65535];
+ *		MATCH_LEN+	- continuation of match length, encoded like LIT_LEN+.
+ *	LAST SEQUENCE	- TOKEN, [LIT_LEN+], LITERALS only; the block ends right after its literals.
+ */
+#ifndef MESSENGER_LZ_HPP
+#define MESSENGER_LZ_HPP
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace messenger
+{
+namespace lz
+{
+
+/**
+* Compress specified text
+*
+* @param text text to compress, may be empty
+* @return compressed block
+*/
+std::string compress(std::string_view text);
+
+
+/**
+* Restore the original text from a compressed block
+*
+* @param block compressed block produced by compress
+* @return original text
+*
+* @note If the block is malformed throw std::runtime_error
+*/
+std::string decompress(std::string_view block);
+
+
+/**
+* Size of the original text stored in a compressed block
+*
+* @note If the block is malformed throw std::runtime_error
+*/
+size_t decompressed_size(std::string_view block);
+
+
+/**
+* Restore the original text from a compressed block into a caller provided area
+*
+* @param block compressed block produced by compress
+* @param out destination of the original text
+* @param size size of out, must be equal to decompressed_size(block)
+*
+* @note If the block is malformed or its text size differs from size throw std::runtime_error
+*/
+void decompress(std::string_view block, char* out, size_t size);
+
+}	// namespace lz
+}	// namespace messenger
+
+#endif // !MESSENGER_LZ_HPP
@@ -0,0 +1,116 @@
+/**
+ * @file   messenger_pipeline.hpp
+ * @brief  Multi-stage receive pipeline spreading the parse_buff work over several cores.
+ *
+ * @detail Every raw message buffer goes through four stages, each running on its own thread and
+ *	connected to the next one by a lock-free single producer / single consumer queue:
+ *
+ *	push --> [ scan ] --> [ validate ] --> [ materialize ] --> [ dispatch ] --> handlers
+ *
+ *	scan		- FLAG, NAME_LEN and MSG_LEN of every packet, packet boundaries (detail::scan_buff);
+ *				the only stage reading the headers, the others use the recorded packet offsets;
+ *	validate	- CRC4 of every packet (detail::verify_buff);
+ *	materialize	- msg_t construction (detail::materialize);
+ *	dispatch	- user handlers, in the order the buffers were pushed.
+ *
+ *	Stages move items between queues in batches and prefetch the buffer of the next item of a batch
+ *	while working on the current one. A stage with nothing to do spins briefly, then sleeps until its
+ *	input queue receives items.
+ */
+#ifndef MESSENGER_PIPELINE_HPP
+#define MESSENGER_PIPELINE_HPP
+
+#include <stdint.h>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "task1_messenger.hpp"
+
+namespace messenger
+{
+
+/**
+	* Helper type to represent pipeline tuning knobs
+	*/
+struct pipeline_config_t
+{
+	size_t queue_capacity = 1024;	/**< items between two stages, rounded up to a power of two */
+	size_t batch_size = 32;			/**< items a stage takes from its input queue at once */
+	bool prefetch = true;			/**< prefetch the buffer of the next item */
+};
+
+
+/**
+	* Helper type to represent pipeline counters
+	*/
+struct pipeline_stats_t
+{
+	uint64_t dispatched;		/**< messages the message handler returned from */
+	uint64_t failed;			/**< buffers rejected by one of the stages */
+	uint64_t handler_errors;	/**< exceptions thrown by either handler */
+};
+
+
+/**
+	* Receive pipeline
+	*
+	* @note push is meant to be called from a single thread. Both handlers are called from the dispatch
+	*	thread. An exception escaping a handler does not stop the pipeline: it is counted in
+	*	pipeline_stats_t::handler_errors and the first one is rethrown by finish.
+	*
+	* @sample
+	*
+	* messenger::receive_pipeline pipeline([](const messenger::msg_t& msg) { std::cout << msg.text; });
+	*
+	* pipeline.push(std::move(buff));
+	* pipeline.finish();	// every pushed buffer has been dispatched
+	*/
+class receive_pipeline
+{
+public:
+	using msg_handler_t = std::function<void(const msg_t&)>;
+	using error_handler_t = std::function<void(std::exception_ptr)>;
+
+	/**
+	* @param on_msg called for every valid buffer
+	* @param on_error called with the parse_buff error of every invalid buffer, may be empty
+	* @param config tuning knobs
+	*/
+	receive_pipeline(msg_handler_t on_msg, error_handler_t on_error = nullptr, pipeline_config_t config = pipeline_config_t());
+
+	receive_pipeline(const receive_pipeline&) = delete;
+	receive_pipeline& operator=(const receive_pipeline&) = delete;
+
+	/**
+	* Calls finish, a handler exception is not rethrown
+	*/
+	~receive_pipeline();
+
+	/**
+	* Queue specified raw message buffer, waiting while the first stage is full
+	*
+	* @note After finish throw std::logic_error
+	*/
+	void push(std::vector<uint8_t> buff);
+
+	/**
+	* Wait until every pushed buffer is dispatched and stop the stage threads
+	*
+	* @note Rethrows the first exception thrown by a handler, once
+	*/
+	void finish();
+
+	pipeline_stats_t stats() const;
+
+private:
+	struct impl_t;
+
+	std::unique_ptr<impl_t> impl;
+};
+
+}	// namespace messenger
+
+#endif // !MESSENGER_PIPELINE_HPP
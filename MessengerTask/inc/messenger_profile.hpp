@@ -0,0 +1,131 @@
+/**
+ * @file   messenger_profile.hpp
+ * @brief  Optional per-stage latency profiling of the messenger codec.
+ *
+ * @detail When the library is built with MESSENGER_PROFILING (cmake -DMESSENGER_PROFILING=ON) every
+ *	instrumented stage records a pair of timestamps (TSC where available) into a ring buffer owned by
+ *	the calling thread. The recorded events can be summarized as per-stage histograms or exported in
+ *	Chrome trace format (chrome://tracing, Perfetto).
+ *
+ *	Without MESSENGER_PROFILING the MESSENGER_PROFILE_SCOPE macro expands to nothing and none of the
+ *	functions below are declared.
+ */
+#ifndef MESSENGER_PROFILE_HPP
+#define MESSENGER_PROFILE_HPP
+
+#ifdef MESSENGER_PROFILING
+
+#include <stdint.h>
+#include <cstddef>
+#include <ostream>
+#include <vector>
+
+namespace messenger
+{
+namespace profile
+{
+
+/**
+	* Instrumented codec stages
+	*/
+enum class stage_t : uint8_t
+{
+	header,				/**< Header construction (encoding or parsing) */
+	payload,			/**< Payload name / message copies */
+	crc,				/**< CRC::Calculate */
+	text_splitter,		/**< splitting message text into packet sized chunks */
+	packet_splitter,	/**< splitting raw buffer into packets */
+
+	count
+};
+
+/**
+	* Helper type to represent one timed stage
+	*/
+struct event_t
+{
+	uint64_t start;		/**< in ticks */
+	uint64_t end;		/**< in ticks */
+	uint32_t thread;	/**< profiling id of the recording thread */
+	stage_t stage;
+};
+
+static constexpr size_t events_per_thread = 1 << 16;	/**< older events are overwritten */
+
+const char* stage_name(stage_t stage);
+
+/**
+* Current timestamp in ticks
+*/
+uint64_t now();
+
+/**
+* Number of ticks in one microsecond, calibrated on first use
+*/
+double ticks_per_us();
+
+void record(stage_t stage, uint64_t start, uint64_t end);
+
+/**
+* Copy events recorded by all threads, ordered by start time
+*
+* @note Call when the instrumented threads are idle, events being written concurrently may be torn
+*/
+std::vector<event_t> collect();
+
+/**
+* Drop all recorded events
+*
+* @note Also frees the buffers of exited threads; until then a new thread reuses one of them
+*/
+void reset();
+
+/**
+* Print count, percentiles and a log2 histogram of durations for every stage
+*/
+void write_histograms(std::ostream& out, const std::vector<event_t>& events);
+
+/**
+* Print events as Chrome trace JSON
+*/
+void write_chrome_trace(std::ostream& out, const std::vector<event_t>& events);
+
+/**
+	* Records the lifetime of the object as one event of specified stage
+	*/
+class scope_t
+{
+private:
+	stage_t stage;
+	uint64_t start;
+
+public:
+	scope_t(stage_t stage)
+		: stage(stage)
+		, start(now())
+	{}
+
+	scope_t(const scope_t&) = delete;
+	scope_t& operator=(const scope_t&) = delete;
+
+	~scope_t()
+	{
+		record(stage, start, now());
+	}
+};
+
+}	// namespace profile
+}	// namespace messenger
+
+#define MESSENGER_PROFILE_CONCAT_(a, b) a##b
+#define MESSENGER_PROFILE_CONCAT(a, b) MESSENGER_PROFILE_CONCAT_(a, b)
+#define MESSENGER_PROFILE_SCOPE(stage) \
+	messenger::profile::scope_t MESSENGER_PROFILE_CONCAT(profile_scope_, __LINE__)(messenger::profile::stage_t::stage)
+
+#else
+
+#define MESSENGER_PROFILE_SCOPE(stage)
+
+#endif // MESSENGER_PROFILING
+
+#endif // !MESSENGER_PROFILE_HPP
@@ -0,0 +1,124 @@
+/**
+ * @file   messenger_shm.hpp
+ * @brief  Shared memory channel carrying raw message buffers between processes on the same host.
+ *
+ * @detail The channel is a single producer / single consumer ring placed in a POSIX shared memory
+ *	object. Every record holds one raw message buffer exactly as make_buff produces it:
+ *
+ *	+-record----------------------------------------------+
+ *	|  LEN [4 bytes]  |  raw message buffer [LEN bytes]   |  padded to 8 bytes
+ *	+-----------------------------------------------------+
+ *
+ *	A record never wraps around the end of the ring; the unused tail is marked with a padding record.
+ *	The producer encodes messages straight into the ring and the consumer parses them in place, so
+ *	the fast path is a couple of atomic operations. The futex system calls are made only when one side
+ *	has announced it is going to sleep on an empty (or full) ring.
+ *
+ * @note Available on Linux only.
+ */
+#ifndef MESSENGER_SHM_HPP
+#define MESSENGER_SHM_HPP
+
+#include <stdint.h>
+#include <cstddef>
+#include <span>
+#include <string>
+
+#include "task1_messenger.hpp"
+
+namespace messenger
+{
+
+/**
+	* One end of a shared memory channel
+	*
+	* @sample
+	*
+	* // process A
+	* messenger::shm_channel producer("/messenger", 1 << 20);
+	* producer.send(messenger::msg_t("Timur", "Hi"));
+	*
+	* // process B
+	* messenger::shm_channel consumer("/messenger");
+	* messenger::msg_t msg = consumer.receive();
+	*/
+class shm_channel
+{
+public:
+	/**
+	* Create a new channel, the shared memory object is removed when this end is destroyed
+	*
+	* @param name shared memory object name, e.g. "/messenger"
+	* @param capacity ring size in bytes, rounded up to a multiple of 8
+	*
+	* @note System call failures are reported with std::system_error
+	*/
+	shm_channel(const std::string& name, size_t capacity);
+
+	/**
+	* Attach to an existing channel
+	*/
+	shm_channel(const std::string& name);
+
+	shm_channel(const shm_channel&) = delete;
+	shm_channel& operator=(const shm_channel&) = delete;
+
+	~shm_channel();
+
+	/**
+	* Encode specified message into the ring, waiting while the ring is full
+	*
+	* @note Errors of make_buff are propagated; a message larger than the ring throws std::length_error
+	*/
+	void send(const msg_t& msg);
+
+	/**
+	* Encode specified message into the ring if there is enough free space
+	*
+	* @return false if the ring is full
+	*/
+	bool try_send(const msg_t& msg);
+
+	/**
+	* Oldest raw message buffer in the ring, left in place until release is called
+	*
+	* @return empty span if the ring is empty
+	*
+	* @note A record length pointing outside the ring throws std::runtime_error
+	*/
+	std::span<const uint8_t> peek();
+
+	/**
+	* Same as peek, waiting while the ring is empty
+	*/
+	std::span<const uint8_t> wait();
+
+	/**
+	* Give the buffer returned by peek or wait back to the producer
+	*/
+	void release();
+
+	/**
+	* Wait for the next message and parse it in place
+	*
+	* @note Errors of parse_buff are propagated; the invalid buffer is released anyway
+	*/
+	msg_t receive();
+
+private:
+	struct ring_t;
+
+	void map(int fd, size_t size);
+
+	std::string name;
+	bool owner;			/**< this end created the shared memory object */
+	void* segment;
+	size_t segment_size;
+	ring_t* ring;
+	uint8_t* data;
+	size_t pending;		/**< size of the record returned by peek, 0 if none */
+};
+
+}	// namespace messenger
+
+#endif // !MESSENGER_SHM_HPP
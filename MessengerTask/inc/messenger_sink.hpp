@@ -0,0 +1,183 @@
+/**
+ * @file   messenger_sink.hpp
+ * @brief  Output sinks accepted by the templated messenger::make_buff.
+ *
+ * @detail A sink is any type providing
+ *
+ *		void write(const uint8_t* data, size_t size);
+ *
+ *	make_buff calls write once per encoded packet, in order. A sink backed by contiguous memory may also
+ *	provide
+ *
+ *		uint8_t* reserve(size_t size);	// writable memory for the next size bytes
+ *		void commit(size_t size);		// those bytes are now part of the output
+ *
+ *	in which case make_buff encodes every packet straight into the reserved memory instead of copying it
+ *	through write. The sinks below cover the common memory
+ *	backends: a fixed contiguous area (NIC registered buffer, shared memory segment), any byte container
+ *	with its own allocator (std::pmr::vector, std::string) and a scatter list of iovec-like segments.
+ */
+#ifndef MESSENGER_SINK_HPP
+#define MESSENGER_SINK_HPP
+
+#include <stdint.h>
+#include <cstddef>
+#include <cstring>
+#include <concepts>
+#include <span>
+#include <stdexcept>
+
+namespace messenger
+{
+
+template <typename Sink>
+concept packet_sink = requires(Sink& sink, const uint8_t* data, size_t size)
+{
+	sink.write(data, size);
+};
+
+template <typename Sink>
+concept contiguous_packet_sink = packet_sink<Sink> && requires(Sink& sink, size_t size)
+{
+	{ sink.reserve(size) } -> std::same_as<uint8_t*>;
+	sink.commit(size);
+};
+
+
+/**
+	* Sink writing into a fixed contiguous memory area
+	*
+	* @note If the area is too small throw std::length_error; the bytes written so far stay in place
+	*/
+class span_sink
+{
+private:
+	std::span<uint8_t> area;
+	size_t written;
+
+public:
+	span_sink(std::span<uint8_t> area)
+		: area(area)
+		, written(0)
+	{}
+
+	uint8_t* reserve(size_t size)
+	{
+		if (area.size() - written < size) throw std::length_error("error: output buffer is too small");
+
+		return area.data() + written;
+	}
+
+	void commit(size_t size)
+	{
+		written += size;
+	}
+
+	void write(const uint8_t* data, size_t size)
+	{
+		std::memcpy(reserve(size), data, size);
+		commit(size);
+	}
+
+	size_t size() const
+	{
+		return written;
+	}
+};
+
+
+/**
+	* Sink appending to the end of a byte container, e.g. std::vector<uint8_t, Allocator>,
+	* std::pmr::vector<uint8_t> or std::string
+	*
+	* @note Containers with data() and resize() get the packets encoded in place
+	*/
+template <typename Container>
+class back_insert_sink
+{
+private:
+	Container& container;
+	size_t reserved;	/**< container size before the last reserve */
+
+public:
+	back_insert_sink(Container& container)
+		: container(container)
+		, reserved(0)
+	{}
+
+	uint8_t* reserve(size_t size) requires requires(Container& c) { c.data(); c.resize(size_t()); }
+	{
+		reserved = container.size();
+		container.resize(reserved + size);
+
+		return reinterpret_cast<uint8_t*>(container.data() + reserved);
+	}
+
+	void commit(size_t size) requires requires(Container& c) { c.data(); c.resize(size_t()); }
+	{
+		container.resize(reserved + size);
+	}
+
+	void write(const uint8_t* data, size_t size)
+	{
+		container.insert(container.end(), data, data + size);
+	}
+};
+
+
+/**
+	* Sink scattering the output over a list of segments described by iov_base/iov_len members,
+	* e.g. struct iovec, so that the result can be passed to writev/sendmsg as is
+	*
+	* @note A packet may be split between two segments. If the segments are too small throw std::length_error.
+	*/
+template <typename Iovec>
+class iovec_sink
+{
+private:
+	std::span<const Iovec> segments;
+	size_t segment;		/**< index of the segment being filled */
+	size_t offset;		/**< bytes already written to that segment */
+	size_t written;
+
+public:
+	iovec_sink(std::span<const Iovec> segments)
+		: segments(segments)
+		, segment(0)
+		, offset(0)
+		, written(0)
+	{}
+
+	void write(const uint8_t* data, size_t size)
+	{
+		while (size != 0)
+		{
+			if (segment == segments.size()) throw std::length_error("error: output buffer is too small");
+
+			size_t chunk = segments[segment].iov_len - offset;
+			if (chunk > size) chunk = size;
+
+			std::memcpy(static_cast<uint8_t*>(segments[segment].iov_base) + offset, data, chunk);
+
+			data += chunk;
+			size -= chunk;
+			offset += chunk;
+			written += chunk;
+
+			if (offset == segments[segment].iov_len)
+			{
+				segment++;
+				offset = 0;
+			}
+		}
+	}
+
+	size_t size() const
+	{
+		return written;
+	}
+};
+
+}	// namespace messenger
+
+#endif // !MESSENGER_SINK_HPP
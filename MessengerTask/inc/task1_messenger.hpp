@@ -33,22 +33,62 @@
 #include <cassert>
 #include <vector>
 #include <string>
+#include <string_view>
+#include <span>
+#include <memory>
+
+#include "messenger_sink.hpp"
+#include "messenger_lz.hpp"
 
 namespace messenger
 {
 
 /**
 	* Helper type to represent message: sender name, message text
+	*
+	* @note Allocator is used for both strings, e.g. std::pmr::polymorphic_allocator<char>
 	*/
-struct msg_t
+template <typename Allocator = std::allocator<char>>
+struct basic_msg_t
 {
-	msg_t(const std::string& nm, const std::string& txt)
+	using string_type = std::basic_string<char, std::char_traits<char>, Allocator>;
+
+	basic_msg_t(const string_type& nm, const string_type& txt)
 		: name(nm)
 		, text(txt)
 	{}
 
-	std::string name;	/**< message sender's name */
-	std::string text;	/**< message text */
+	basic_msg_t(std::string_view nm, std::string_view txt, const Allocator& alloc)
+		: name(nm, alloc)
+		, text(txt, alloc)
+	{}
+
+	string_type name;	/**< message sender's name */
+	string_type text;	/**< message text */
+};
+
+using msg_t = basic_msg_t<>;
+
+
+/**
+	* Helper type to represent a batch of messages column by column (structure of arrays)
+	*
+	* @note message i occupies names[name_offsets[i] .. name_offsets[i + 1]) and
+	*	texts[text_offsets[i] .. text_offsets[i + 1]), so both offset arrays hold size() + 1 values
+	*/
+struct msg_batch_t
+{
+	std::vector<char> names;				/**< sender names of all messages, back to back */
+	std::vector<uint32_t> name_offsets;		/**< start of every name in names, followed by names.size() */
+	std::vector<char> texts;				/**< texts of all messages, back to back */
+	std::vector<uint32_t> text_offsets;		/**< start of every text in texts, followed by texts.size() */
+	std::vector<uint8_t> name_lens;			/**< sender name length of every message */
+	std::vector<uint32_t> packet_counts;	/**< number of packets every message was transferred in */
+
+	size_t size() const
+	{
+		return name_lens.size();
+	}
 };
 
 
@@ -73,6 +113,19 @@ struct msg_t
 std::vector<uint8_t> make_buff(const msg_t& msg);
 
 
+/**
+	* Prepare raw message buffer from specified message, compressing the message text
+	*
+	* @note The text is compressed with messenger::lz before it is split into packets and every packet
+	*	carries FLAG value 110 instead of 101. parse_buff restores the original text transparently.
+	*	If compression does not make the text shorter the buffer is the same as the one of make_buff.
+	*
+	* @param msg message sender's name & message text
+	* @return buffer with prepared message packets
+	*/
+std::vector<uint8_t> make_compressed_buff(const msg_t& msg);
+
+
 /**
 * Parse specified raw message buffer to get original message
 *
@@ -83,9 +136,274 @@ std::vector<uint8_t> make_buff(const msg_t& msg);
 *	- FLAG;
 *	- CRC4.
 * If their value will be incorrect throw std::runtime_error
+*
+* @note Buffers prepared by make_compressed_buff are decompressed transparently.
 */
 msg_t parse_buff(std::vector<uint8_t>& buff);
 
+
+/**
+* Parse specified raw message buffers into a column oriented batch
+*
+* @param buffs raw message buffers, one message per buffer, left unmodified
+* @return parsed messages, in the order of buffs
+*
+* @note Fields are verified the same way as in parse_buff; a truncated packet is reported with
+* std::runtime_error as well. If any buffer is invalid no batch is returned.
+*
+* @note If names or texts would not be addressable by the 32 bit offsets throw std::length_error
+*/
+msg_batch_t parse_batch(const std::vector<std::vector<uint8_t>>& buffs);
+
+
+namespace detail
+{
+
+static constexpr uint8_t header_size = 2;		/**< FLAG, NAME_LEN, MSG_LEN and CRC4 fields, in bytes */
+static constexpr uint8_t max_name_len = 15;		/**< largest NAME_LEN value */
+static constexpr uint8_t max_msg_len = 31;		/**< largest MSG_LEN value */
+
+static constexpr size_t max_packet_size = header_size + max_name_len + max_msg_len;
+
+/**
+* Location and header fields of one packet inside a raw message buffer
+*/
+struct packet_ref_t
+{
+	size_t offset;		/**< of the packet header inside the buffer */
+	uint8_t name_len;
+	uint8_t msg_len;
+	uint8_t crc4;		/**< as stored in the header */
+	bool compressed;	/**< FLAG value 110 */
+};
+
+inline size_t packet_size(const packet_ref_t& packet)
+{
+	return header_size + packet.name_len + packet.msg_len;
+}
+
+inline std::string_view packet_name(std::span<const uint8_t> buff, const packet_ref_t& packet)
+{
+	return std::string_view(reinterpret_cast<const char*>(buff.data() + packet.offset + header_size), packet.name_len);
+}
+
+inline std::string_view packet_msg(std::span<const uint8_t> buff, const packet_ref_t& packet)
+{
+	return std::string_view(reinterpret_cast<const char*>(buff.data() + packet.offset + header_size + packet.name_len), packet.msg_len);
+}
+
+/**
+* Layout of a verified raw message buffer
+*/
+struct buff_layout_t
+{
+	std::string_view name;				/**< sender name inside the buffer */
+	size_t text_size;					/**< sum of all MSG fields */
+	bool compressed;					/**< MSG fields hold a messenger::lz block */
+	std::vector<packet_ref_t> packets;	/**< so that later steps do not read the headers again */
+};
+
+/**
+* Size of the raw message buffer make_buff produces for the specified name and text
+*/
+size_t buff_size(std::string_view name, std::string_view text);
+
+/**
+* Size of the packet encode_packet produces next for the specified name and remaining text
+*
+* @note Name and text are checked as in make_buff: std::length_error
+*/
+size_t next_packet_size(std::string_view name, std::string_view text);
+
+/**
+* Encode the next packet of a message: consume up to MAX_MSG_LEN bytes from the front of text
+*
+* @param out at least max_packet_size bytes
+* @return size of the encoded packet
+*/
+size_t encode_packet(std::string_view name, std::string_view& text, uint8_t* out);
+
+/**
+* Sender name of a raw message buffer, reading the first Header and NAME only
+*
+* @note If the FLAG is invalid or the first packet is truncated throw std::runtime_error
+*/
+std::string_view peek_sender(std::span<const uint8_t> buff);
+
+/**
+* Read the header of the packet starting at pos
+*
+* @note If the FLAG is invalid or the packet is truncated throw std::runtime_error
+*/
+packet_ref_t read_packet(std::span<const uint8_t> buff, size_t pos);
+
+/**
+* Verify CRC4 of a packet returned by read_packet, without modifying the buffer
+*
+* @note If the CRC4 is invalid throw std::runtime_error
+*/
+void verify_packet(std::span<const uint8_t> buff, const packet_ref_t& packet);
+
+/**
+* Call on_packet with every packet of a raw message buffer, in order, reading each header once
+*
+* @return true if the MSG fields hold a messenger::lz block
+*
+* @note FLAG and boundaries are verified as in scan_buff, CRC4 is left to on_packet (see verify_packet)
+*/
+template <typename OnPacket>
+bool for_each_packet(std::span<const uint8_t> buff, OnPacket on_packet)
+{
+	if (buff.empty()) throw std::runtime_error("error: empty buffer");
+
+	bool compressed = false;
+
+	for (size_t pos = 0; pos != buff.size(); )
+	{
+		packet_ref_t packet = read_packet(buff, pos);
+
+		if (pos == 0) compressed = packet.compressed;
+		else if (packet.compressed != compressed) throw std::runtime_error("error: invalid flag");
+
+		on_packet(packet);
+		pos += packet_size(packet);
+	}
+
+	return compressed;
+}
+
+/**
+* Verify FLAG and packet boundaries of the whole buffer without modifying it, recording every packet
+*/
+buff_layout_t scan_buff(std::span<const uint8_t> buff);
+
+/**
+* Verify CRC4 of every packet of a buffer already checked by scan_buff, without modifying it
+*/
+void verify_buff(std::span<const uint8_t> buff, const buff_layout_t& layout);
+
+/**
+* Copy the MSG fields of a verified buffer back to back into out (layout.text_size bytes)
+*/
+void gather_text(std::span<const uint8_t> buff, const buff_layout_t& layout, char* out);
+
+}	// namespace detail
+
+
+/**
+	* Encode specified message directly into an output sink
+	*
+	* @note Produces the same bytes as make_buff(const msg_t&); errors are reported the same way
+	*
+	* @param msg message sender's name & message text
+	* @param sink destination of the encoded packets, see messenger_sink.hpp
+	*
+	* @sample
+	*
+	* uint8_t area[256];
+	* messenger::span_sink sink(area);
+	* messenger::make_buff(messenger::msg_t("Timur", "Hi"), sink);
+	* // sink.size() bytes of area hold the encoded message
+	*/
+template <typename Allocator, packet_sink Sink>
+void make_buff(const basic_msg_t<Allocator>& msg, Sink& sink)
+{
+	std::string_view name(msg.name);
+	std::string_view text(msg.text);
+
+	do
+	{
+		if constexpr (contiguous_packet_sink<Sink>)
+		{
+			// encoded in place: the size is known and the fields are checked before any sink memory is taken
+			size_t size = detail::next_packet_size(name, text);
+
+			detail::encode_packet(name, text, sink.reserve(size));
+			sink.commit(size);
+		}
+		else
+		{
+			uint8_t packet[detail::max_packet_size];
+
+			sink.write(packet, detail::encode_packet(name, text, packet));
+		}
+	} while (!text.empty());
+}
+
+
+namespace detail
+{
+
+/**
+* Build the message of a buffer verified by scan_buff and verify_buff
+*/
+template <typename Allocator>
+basic_msg_t<Allocator> materialize(std::span<const uint8_t> buff, const buff_layout_t& layout, const Allocator& alloc)
+{
+	basic_msg_t<Allocator> msg(layout.name, std::string_view(), alloc);
+
+	if (!layout.compressed)
+	{
+		msg.text.resize(layout.text_size);
+		detail::gather_text(buff, layout, msg.text.data());
+
+		return msg;
+	}
+
+	// only the compressed block goes through a temporary, the text is restored straight into msg.text
+	std::string block(layout.text_size, '\0');
+	detail::gather_text(buff, layout, block.data());
+
+	msg.text.resize(lz::decompressed_size(block));
+	lz::decompress(block, msg.text.data(), msg.text.size());
+
+	return msg;
+}
+
+}	// namespace detail
+
+
+/**
+* Parse specified raw message buffer into strings that use the specified allocator
+*
+* @param buff raw message buffer, left unmodified
+* @param alloc allocator of the resulting strings
+* @return parsed message
+*
+* @note Fields are verified the same way as in parse_buff(std::vector<uint8_t>&);
+* a truncated packet is reported with std::runtime_error as well.
+*/
+template <typename Allocator = std::allocator<char>>
+basic_msg_t<Allocator> parse_buff(std::span<const uint8_t> buff, const Allocator& alloc = Allocator())
+{
+	basic_msg_t<Allocator> msg(std::string_view(), std::string_view(), alloc);
+	msg.text.reserve(buff.size());	// the MSG fields never take more
+
+	bool first = true;
+
+	// a single pass: every packet is verified and appended as soon as its header is read
+	bool compressed = detail::for_each_packet(buff, [&](const detail::packet_ref_t& packet)
+	{
+		detail::verify_packet(buff, packet);
+
+		if (first) msg.name = detail::packet_name(buff, packet);
+		first = false;
+
+		msg.text += detail::packet_msg(buff, packet);
+	});
+
+	if (!compressed) return msg;
+
+	// the gathered MSG fields are the block, the text is restored straight into msg.text
+	typename basic_msg_t<Allocator>::string_type block(std::move(msg.text));
+
+	msg.text.clear();
+	msg.text.resize(lz::decompressed_size(block));
+	lz::decompress(block, msg.text.data(), msg.text.size());
+
+	return msg;
+}
+
 }	// namespace messenger
 
 #endif // !TASK1_MESSENGER_HPP
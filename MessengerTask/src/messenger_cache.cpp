@@ -0,0 +1,105 @@
+// messenger_cache.cpp : Defines the decoded-message cache.
+//
+#include <functional>
+
+#include "messenger_cache.hpp"
+
+messenger::parse_cache::parse_cache(size_t capacity, size_t shards_count)
+	: hits(0)
+	, misses(0)
+{
+	if (capacity == 0) throw std::invalid_argument("error: cache capacity cannot be zero");
+	if (shards_count == 0) throw std::invalid_argument("error: shards count cannot be zero");
+
+	// never keep more shards than entries, otherwise the capacity bound is exceeded
+	if (shards_count > capacity) shards_count = capacity;
+
+	shards = std::vector<shard_t>(shards_count);
+
+	// the first capacity % shards_count shards take one extra entry, so the shards add up to capacity
+	for (size_t i = 0; i != shards_count; i++)
+	{
+		shards[i].capacity = capacity / shards_count + (i < capacity % shards_count ? 1 : 0);
+	}
+}
+
+messenger::parse_cache::key_t messenger::parse_cache::make_key(const std::vector<uint8_t>& buff)
+{
+	std::string_view bytes(reinterpret_cast<const char*>(buff.data()), buff.size());
+
+	return { std::hash<std::string_view>{}(bytes), bytes };
+}
+
+messenger::msg_t messenger::parse_cache::parse(const std::vector<uint8_t>& buff)
+{
+	key_t key = make_key(buff);
+	shard_t& shard = shards[key.hash % shards.size()];
+
+	{
+		std::lock_guard<std::mutex> guard(shard.lock);
+
+		auto found = shard.index.find(key);
+		if (found != shard.index.end())
+		{
+			shard.lru.splice(shard.lru.begin(), shard.lru, found->second);
+			hits.fetch_add(1, std::memory_order_relaxed);
+			return found->second->msg;
+		}
+	}
+
+	misses.fetch_add(1, std::memory_order_relaxed);
+
+	entry_t entry{ buff, parse_buff(std::span<const uint8_t>(buff)) };
+
+	std::lock_guard<std::mutex> guard(shard.lock);
+
+	// another thread may have decoded the same buffer while the lock was released
+	auto found = shard.index.find(key);
+	if (found != shard.index.end())
+	{
+		shard.lru.splice(shard.lru.begin(), shard.lru, found->second);
+		return found->second->msg;
+	}
+
+	shard.lru.push_front(std::move(entry));
+	shard.index.emplace(key_t{ key.hash, make_key(shard.lru.front().raw).bytes }, shard.lru.begin());
+
+	if (shard.lru.size() > shard.capacity)
+	{
+		shard.index.erase(make_key(shard.lru.back().raw));
+		shard.lru.pop_back();
+	}
+
+	return shard.lru.front().msg;
+}
+
+messenger::cache_stats_t messenger::parse_cache::stats() const
+{
+	return { hits.load(std::memory_order_relaxed), misses.load(std::memory_order_relaxed) };
+}
+
+size_t messenger::parse_cache::size() const
+{
+	size_t total = 0;
+
+	for (const shard_t& shard : shards)
+	{
+		std::lock_guard<std::mutex> guard(shard.lock);
+		total += shard.lru.size();
+	}
+
+	return total;
+}
+
+void messenger::parse_cache::clear()
+{
+	for (shard_t& shard : shards)
+	{
+		std::lock_guard<std::mutex> guard(shard.lock);
+		shard.index.clear();
+		shard.lru.clear();
+	}
+
+	hits.store(0, std::memory_order_relaxed);
+	misses.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,97 @@
+// messenger_filter.cpp : Defines the sender filtered decoding.
+//
+#include <cstring>
+#include <stdexcept>
+
+#include "messenger_filter.hpp"
+
+#define KEY_SIZE (16)			// in bytes
+
+static_assert(messenger::detail::max_name_len < KEY_SIZE, "a name and its length must fit in a key");
+
+messenger::sender_filter::key_t messenger::sender_filter::pack(std::string_view name)
+{
+	uint8_t bytes[KEY_SIZE] = {};
+
+	std::memcpy(bytes, name.data(), name.size());
+	bytes[KEY_SIZE - 1] = static_cast<uint8_t>(name.size());
+
+	key_t key;
+	std::memcpy(&key.lo, bytes, sizeof(key.lo));
+	std::memcpy(&key.hi, bytes + sizeof(key.lo), sizeof(key.hi));
+
+	return key;
+}
+
+size_t messenger::sender_filter::slot_of(const key_t& key) const
+{
+	uint64_t hash = (key.lo * 0x9e3779b97f4a7c15ull) ^ (key.hi * 0xc2b2ae3d27d4eb4full);
+
+	return static_cast<size_t>(hash ^ (hash >> 32)) & mask;
+}
+
+messenger::sender_filter::sender_filter(const std::vector<std::string>& senders)
+	: count(0)
+{
+	// at most half of the slots are used, so that probe sequences stay short
+	size_t size = 2;
+	while (size < 2 * senders.size()) size <<= 1;
+
+	slots.assign(size, key_t{ 0, 0 });
+	mask = size - 1;
+
+	for (const std::string& sender : senders)
+	{
+		if (sender.empty()) throw std::length_error("error: name cannot be empty");
+		if (sender.size() > messenger::detail::max_name_len) throw std::length_error("error: name is too long");
+
+		key_t key = pack(sender);
+
+		for (size_t slot = slot_of(key); ; slot = (slot + 1) & mask)
+		{
+			if (slots[slot].lo == key.lo && slots[slot].hi == key.hi) break;	// duplicate
+
+			if (slots[slot].hi == 0)
+			{
+				slots[slot] = key;
+				count++;
+				break;
+			}
+		}
+	}
+}
+
+bool messenger::sender_filter::contains(std::string_view name) const
+{
+	if (name.empty() || name.size() > messenger::detail::max_name_len) return false;
+
+	key_t key = pack(name);
+
+	for (size_t slot = slot_of(key); slots[slot].hi != 0; slot = (slot + 1) & mask)
+	{
+		if (slots[slot].lo == key.lo && slots[slot].hi == key.hi) return true;
+	}
+
+	return false;
+}
+
+std::optional<messenger::msg_t> messenger::parse_filtered(std::span<const uint8_t> buff, const sender_filter& filter)
+{
+	if (!filter.contains(detail::peek_sender(buff))) return std::nullopt;
+
+	return parse_buff(buff);
+}
+
+std::vector<messenger::msg_t> messenger::parse_filtered(const std::vector<std::vector<uint8_t>>& buffs, const sender_filter& filter)
+{
+	std::vector<msg_t> msgs;
+
+	for (const std::vector<uint8_t>& buff : buffs)
+	{
+		std::optional<msg_t> msg = parse_filtered(std::span<const uint8_t>(buff), filter);
+
+		if (msg) msgs.push_back(std::move(*msg));
+	}
+
+	return msgs;
+}
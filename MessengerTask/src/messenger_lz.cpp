@@ -0,0 +1,203 @@
+// messenger_lz.cpp : Defines the LZ77 style text codec.
+//
+#include <stdint.h>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#include "messenger_lz.hpp"
+
+#define MIN_MATCH (4)			// in bytes
+#define MAX_OFFSET (0xffff)		// in bytes
+
+#define NIBBLE_MAX (15)
+#define LEN_CONTINUE (255)
+
+#define HASH_LOG (12)			// hash table holds 2^HASH_LOG positions
+
+static uint32_t read32(const uint8_t* ptr)
+{
+	uint32_t value;
+	std::memcpy(&value, ptr, sizeof(value));
+	return value;
+}
+
+static uint32_t hash4(uint32_t value)
+{
+	return (value * 2654435761u) >> (32 - HASH_LOG);
+}
+
+static void write_length(std::string& block, size_t length)
+{
+	while (length >= LEN_CONTINUE)
+	{
+		block.push_back(static_cast<char>(LEN_CONTINUE));
+		length -= LEN_CONTINUE;
+	}
+
+	block.push_back(static_cast<char>(length));
+}
+
+// match_len == 0 writes the last sequence, which carries literals only
+static void write_sequence(std::string& block, const uint8_t* literals, size_t lit_len, size_t offset, size_t match_len)
+{
+	size_t match_code = match_len ? match_len - MIN_MATCH : 0;
+
+	block.push_back(static_cast<char>((std::min<size_t>(lit_len, NIBBLE_MAX) << 4) | std::min<size_t>(match_code, NIBBLE_MAX)));
+
+	if (lit_len >= NIBBLE_MAX) write_length(block, lit_len - NIBBLE_MAX);
+	block.append(reinterpret_cast<const char*>(literals), lit_len);
+
+	if (match_len == 0) return;
+
+	block.push_back(static_cast<char>(offset & 0xff));
+	block.push_back(static_cast<char>(offset >> 8));
+
+	if (match_code >= NIBBLE_MAX) write_length(block, match_code - NIBBLE_MAX);
+}
+
+std::string messenger::lz::compress(std::string_view text)
+{
+	std::string block;
+
+	// original size, so that the decoder can validate its output
+	for (size_t size = text.size(); ; size >>= 7)
+	{
+		if (size < 0x80)
+		{
+			block.push_back(static_cast<char>(size));
+			break;
+		}
+
+		block.push_back(static_cast<char>((size & 0x7f) | 0x80));
+	}
+
+	const uint8_t* begin = reinterpret_cast<const uint8_t*>(text.data());
+	const uint8_t* end = begin + text.size();
+	const uint8_t* anchor = begin;	// first byte not yet written to the block
+	const uint8_t* pos = begin;
+
+	std::vector<const uint8_t*> table(1 << HASH_LOG, nullptr);
+
+	while (end - pos >= MIN_MATCH)
+	{
+		uint32_t hash = hash4(read32(pos));
+		const uint8_t* candidate = table[hash];
+		table[hash] = pos;
+
+		if (candidate == nullptr || pos - candidate > MAX_OFFSET || read32(candidate) != read32(pos))
+		{
+			pos++;
+			continue;
+		}
+
+		size_t match_len = MIN_MATCH;
+		while (pos + match_len != end && candidate[match_len] == pos[match_len]) match_len++;
+
+		write_sequence(block, anchor, pos - anchor, pos - candidate, match_len);
+
+		pos += match_len;
+		anchor = pos;
+	}
+
+	write_sequence(block, anchor, end - anchor, 0, 0);
+
+	return block;
+}
+
+static size_t read_length(std::string_view::const_iterator& pos, std::string_view::const_iterator end, size_t length)
+{
+	if (length != NIBBLE_MAX) return length;
+
+	uint8_t byte;
+
+	do
+	{
+		if (pos == end) throw std::runtime_error("error: corrupted compressed text");
+
+		byte = static_cast<uint8_t>(*pos++);
+		length += byte;
+	} while (byte == LEN_CONTINUE);
+
+	return length;
+}
+
+// reads TEXT_LEN, pos is left at the first sequence
+static size_t read_text_len(std::string_view::const_iterator& pos, std::string_view::const_iterator end)
+{
+	// no block byte produces more than LEN_CONTINUE text bytes, larger sizes are rejected before anything is allocated
+	size_t max_text_len = static_cast<size_t>(end - pos) * LEN_CONTINUE;
+
+	size_t text_len = 0;
+
+	for (unsigned shift = 0; ; shift += 7)
+	{
+		if (pos == end || shift >= sizeof(size_t) * __CHAR_BIT__) throw std::runtime_error("error: corrupted compressed text");
+
+		uint8_t byte = static_cast<uint8_t>(*pos++);
+		text_len |= static_cast<size_t>(byte & 0x7f) << shift;
+
+		if (byte & 0x80) continue;
+
+		if (text_len > max_text_len) throw std::runtime_error("error: corrupted compressed text");
+
+		return text_len;
+	}
+}
+
+size_t messenger::lz::decompressed_size(std::string_view block)
+{
+	auto pos = block.cbegin();
+
+	return read_text_len(pos, block.cend());
+}
+
+void messenger::lz::decompress(std::string_view block, char* out, size_t size)
+{
+	auto pos = block.cbegin();
+	auto end = block.cend();
+
+	if (read_text_len(pos, end) != size) throw std::runtime_error("error: corrupted compressed text");
+
+	size_t written = 0;
+
+	while (true)
+	{
+		if (pos == end) throw std::runtime_error("error: corrupted compressed text");
+
+		uint8_t token = static_cast<uint8_t>(*pos++);
+
+		size_t lit_len = read_length(pos, end, token >> 4);
+		if (static_cast<size_t>(end - pos) < lit_len || size - written < lit_len) throw std::runtime_error("error: corrupted compressed text");
+
+		std::copy(pos, pos + lit_len, out + written);
+		written += lit_len;
+		pos += lit_len;
+
+		if (pos == end) break;	// last sequence
+
+		if (end - pos < 2) throw std::runtime_error("error: corrupted compressed text");
+
+		size_t offset = static_cast<uint8_t>(pos[0]) | (static_cast<size_t>(static_cast<uint8_t>(pos[1])) << 8);
+		pos += 2;
+
+		size_t match_len = read_length(pos, end, token & NIBBLE_MAX) + MIN_MATCH;
+
+		if (offset == 0 || offset > written || size - written < match_len) throw std::runtime_error("error: corrupted compressed text");
+
+		// byte by byte, the match may overlap the bytes it produces
+		for (size_t match_start = written - offset; match_len != 0; match_len--) out[written++] = out[match_start++];
+	}
+
+	if (written != size) throw std::runtime_error("error: corrupted compressed text");
+}
+
+std::string messenger::lz::decompress(std::string_view block)
+{
+	std::string text(decompressed_size(block), '\0');
+
+	decompress(block, text.data(), text.size());
+
+	return text;
+}
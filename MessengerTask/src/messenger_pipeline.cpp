@@ -0,0 +1,379 @@
+// messenger_pipeline.cpp : Defines the multi-stage receive pipeline.
+//
+#include <atomic>
+#include <optional>
+#include <thread>
+#include <utility>
+
+#include "messenger_pipeline.hpp"
+
+#if defined(__GNUC__) || defined(__clang__)
+#define PREFETCH(addr) __builtin_prefetch(addr)
+#elif defined(_MSC_VER)
+#include <xmmintrin.h>
+#define PREFETCH(addr) _mm_prefetch(reinterpret_cast<const char*>(addr), _MM_HINT_T0)
+#else
+#define PREFETCH(addr)
+#endif
+
+#define CACHE_LINE (64)		// in bytes
+#define SPIN_COUNT (64)		// yields before going to sleep
+
+namespace
+{
+
+void notify(std::atomic<uint32_t>& seq, std::atomic<uint32_t>& waiting)
+{
+	seq.fetch_add(1);
+
+	if (waiting.load()) seq.notify_all();
+}
+
+template <typename Ready>
+void wait_until(std::atomic<uint32_t>& seq, std::atomic<uint32_t>& waiting, Ready ready)
+{
+	for (int spin = 0; spin < SPIN_COUNT; spin++)
+	{
+		if (ready()) return;
+
+		std::this_thread::yield();
+	}
+
+	while (!ready())
+	{
+		// announce the sleep before the last check, so that notify either sees it or the check sees the update
+		waiting.store(1);
+		uint32_t seq_val = seq.load();
+
+		if (!ready()) seq.wait(seq_val);
+
+		waiting.store(0);
+	}
+}
+
+/**
+	* Bounded lock-free queue for exactly one producer thread and one consumer thread
+	*/
+template <typename T>
+class spsc_queue
+{
+private:
+	std::vector<T> slots;
+	size_t mask;
+
+	alignas(CACHE_LINE) std::atomic<size_t> head;	/**< next slot to write, owned by the producer */
+	alignas(CACHE_LINE) std::atomic<size_t> tail;	/**< next slot to read, owned by the consumer */
+
+	alignas(CACHE_LINE) std::atomic<uint32_t> data_seq;		/**< the consumer sleeps on it */
+	std::atomic<uint32_t> consumer_waiting;
+
+	alignas(CACHE_LINE) std::atomic<uint32_t> space_seq;	/**< the producer sleeps on it */
+	std::atomic<uint32_t> producer_waiting;
+
+public:
+	spsc_queue(size_t capacity)
+		: head(0)
+		, tail(0)
+		, data_seq(0)
+		, consumer_waiting(0)
+		, space_seq(0)
+		, producer_waiting(0)
+	{
+		size_t size = 1;
+		while (size < capacity) size <<= 1;
+
+		slots.resize(size);
+		mask = size - 1;
+	}
+
+	/**
+	* Move up to count items into the queue, publishing them at once
+	*
+	* @return number of items moved
+	*/
+	size_t push_batch(T* items, size_t count)
+	{
+		size_t write = head.load(std::memory_order_relaxed);
+		size_t free = slots.size() - (write - tail.load(std::memory_order_acquire));
+
+		if (count > free) count = free;
+
+		for (size_t i = 0; i != count; i++) slots[(write + i) & mask] = std::move(items[i]);
+
+		head.store(write + count, std::memory_order_release);
+
+		if (count != 0) notify(data_seq, consumer_waiting);
+
+		return count;
+	}
+
+	/**
+	* Move up to max items out of the queue, appending them to out
+	*
+	* @return number of items moved
+	*/
+	size_t pop_batch(std::vector<T>& out, size_t max)
+	{
+		size_t read = tail.load(std::memory_order_relaxed);
+		size_t count = head.load(std::memory_order_acquire) - read;
+
+		if (count > max) count = max;
+
+		for (size_t i = 0; i != count; i++) out.push_back(std::move(slots[(read + i) & mask]));
+
+		tail.store(read + count, std::memory_order_release);
+
+		if (count != 0) notify(space_seq, producer_waiting);
+
+		return count;
+	}
+
+	/**
+	* Producer side: wait until at least one slot is free
+	*/
+	void wait_for_space()
+	{
+		wait_until(space_seq, producer_waiting, [&]() { return head.load(std::memory_order_relaxed) - tail.load() != slots.size(); });
+	}
+
+	/**
+	* Consumer side: wait until an item is queued or specified flag is set
+	*/
+	void wait_for_data(const std::atomic<bool>& done)
+	{
+		wait_until(data_seq, consumer_waiting, [&]() { return head.load() != tail.load(std::memory_order_relaxed) || done.load(); });
+	}
+
+	/**
+	* Wake the consumer after the flag it waits on has been set
+	*/
+	void wake_consumer()
+	{
+		notify(data_seq, consumer_waiting);
+	}
+};
+
+/**
+	* Helper type to represent a buffer travelling through the stages
+	*/
+struct item_t
+{
+	std::vector<uint8_t> buff;
+	messenger::detail::buff_layout_t layout;	/**< set by scan, refers to buff; packet offsets are reused by later stages */
+	std::optional<messenger::msg_t> msg;		/**< set by materialize */
+	std::exception_ptr error;					/**< set by the first failed stage, later stages skip the item */
+};
+
+void prefetch_buff(const std::vector<uint8_t>& buff)
+{
+	for (size_t offset = 0; offset < buff.size(); offset += CACHE_LINE) PREFETCH(buff.data() + offset);
+}
+
+}	// namespace
+
+struct messenger::receive_pipeline::impl_t
+{
+	msg_handler_t on_msg;
+	error_handler_t on_error;
+	pipeline_config_t config;
+
+	spsc_queue<item_t> scan_queue;
+	spsc_queue<item_t> validate_queue;
+	spsc_queue<item_t> materialize_queue;
+	spsc_queue<item_t> dispatch_queue;
+
+	std::atomic<bool> input_done;
+	std::atomic<bool> scan_done;
+	std::atomic<bool> validate_done;
+	std::atomic<bool> materialize_done;
+	std::atomic<bool> dispatch_done;
+
+	std::atomic<uint64_t> dispatched;
+	std::atomic<uint64_t> failed;
+	std::atomic<uint64_t> handler_errors;
+	std::exception_ptr handler_error;		/**< first exception thrown by a handler, written by the dispatch thread */
+
+	std::vector<std::thread> threads;
+	bool finished;
+
+	impl_t(msg_handler_t on_msg, error_handler_t on_error, pipeline_config_t config)
+		: on_msg(std::move(on_msg))
+		, on_error(std::move(on_error))
+		, config(config)
+		, scan_queue(config.queue_capacity)
+		, validate_queue(config.queue_capacity)
+		, materialize_queue(config.queue_capacity)
+		, dispatch_queue(config.queue_capacity)
+		, input_done(false)
+		, scan_done(false)
+		, validate_done(false)
+		, materialize_done(false)
+		, dispatch_done(false)
+		, dispatched(0)
+		, failed(0)
+		, handler_errors(0)
+		, finished(false)
+	{}
+
+	static void push_all(spsc_queue<item_t>& queue, std::vector<item_t>& items)
+	{
+		size_t pushed = 0;
+
+		while (pushed != items.size())
+		{
+			size_t count = queue.push_batch(items.data() + pushed, items.size() - pushed);
+
+			if (count == 0) queue.wait_for_space();
+			pushed += count;
+		}
+	}
+
+	template <typename Work>
+	void run_stage(spsc_queue<item_t>& in, spsc_queue<item_t>* out, std::atomic<bool>& upstream_done, std::atomic<bool>& done, Work work)
+	{
+		std::vector<item_t> batch;
+		batch.reserve(config.batch_size);
+
+		while (true)
+		{
+			batch.clear();
+
+			// read before popping: once upstream is done, an empty queue means no more items
+			bool upstream_finished = upstream_done.load(std::memory_order_acquire);
+
+			if (in.pop_batch(batch, config.batch_size) == 0)
+			{
+				if (upstream_finished) break;
+
+				in.wait_for_data(upstream_done);
+				continue;
+			}
+
+			for (size_t i = 0; i != batch.size(); i++)
+			{
+				if (config.prefetch && i + 1 != batch.size()) prefetch_buff(batch[i + 1].buff);
+
+				// failed items are passed on untouched, only the last stage reports them
+				if (batch[i].error) 
+				{
+					if (out == nullptr) work(batch[i]);
+					continue;
+				}
+
+				try
+				{
+					work(batch[i]);
+				}
+				catch (...)
+				{
+					batch[i].error = std::current_exception();
+				}
+			}
+
+			if (out != nullptr) push_all(*out, batch);
+		}
+
+		done.store(true, std::memory_order_release);
+
+		if (out != nullptr) out->wake_consumer();
+	}
+};
+
+messenger::receive_pipeline::receive_pipeline(msg_handler_t on_msg, error_handler_t on_error, pipeline_config_t config)
+{
+	if (config.queue_capacity == 0) throw std::invalid_argument("error: queue capacity cannot be zero");
+	if (config.batch_size == 0) throw std::invalid_argument("error: batch size cannot be zero");
+
+	impl = std::make_unique<impl_t>(std::move(on_msg), std::move(on_error), config);
+
+	impl_t* p = impl.get();
+
+	p->threads.emplace_back([p]()
+	{
+		p->run_stage(p->scan_queue, &p->validate_queue, p->input_done, p->scan_done, [](item_t& item)
+		{
+			item.layout = detail::scan_buff(item.buff);
+		});
+	});
+
+	p->threads.emplace_back([p]()
+	{
+		p->run_stage(p->validate_queue, &p->materialize_queue, p->scan_done, p->validate_done, [](item_t& item)
+		{
+			detail::verify_buff(item.buff, item.layout);
+		});
+	});
+
+	p->threads.emplace_back([p]()
+	{
+		p->run_stage(p->materialize_queue, &p->dispatch_queue, p->validate_done, p->materialize_done, [](item_t& item)
+		{
+			item.msg.emplace(detail::materialize(item.buff, item.layout, std::allocator<char>()));
+		});
+	});
+
+	p->threads.emplace_back([p]()
+	{
+		p->run_stage(p->dispatch_queue, nullptr, p->materialize_done, p->dispatch_done, [p](item_t& item)
+		{
+			// handler errors are kept apart from item.error, which is reserved for invalid buffers
+			try
+			{
+				if (item.error)
+				{
+					p->failed.fetch_add(1, std::memory_order_relaxed);
+					if (p->on_error) p->on_error(item.error);
+					return;
+				}
+
+				p->on_msg(*item.msg);
+				p->dispatched.fetch_add(1, std::memory_order_relaxed);
+			}
+			catch (...)
+			{
+				p->handler_errors.fetch_add(1, std::memory_order_relaxed);
+				if (!p->handler_error) p->handler_error = std::current_exception();
+			}
+		});
+	});
+}
+
+messenger::receive_pipeline::~receive_pipeline()
+{
+	try
+	{
+		finish();
+	}
+	catch (...)
+	{
+		// still counted in stats
+	}
+}
+
+void messenger::receive_pipeline::push(std::vector<uint8_t> buff)
+{
+	if (impl->finished) throw std::logic_error("error: pipeline is finished");
+
+	item_t item;
+	item.buff = std::move(buff);
+
+	while (impl->scan_queue.push_batch(&item, 1) == 0) impl->scan_queue.wait_for_space();
+}
+
+void messenger::receive_pipeline::finish()
+{
+	if (impl->finished) return;
+
+	impl->finished = true;
+	impl->input_done.store(true, std::memory_order_release);
+	impl->scan_queue.wake_consumer();
+
+	for (std::thread& thread : impl->threads) thread.join();
+
+	if (impl->handler_error) std::rethrow_exception(std::exchange(impl->handler_error, nullptr));
+}
+
+messenger::pipeline_stats_t messenger::receive_pipeline::stats() const
+{
+	return { impl->dispatched.load(std::memory_order_relaxed), impl->failed.load(std::memory_order_relaxed), impl->handler_errors.load(std::memory_order_relaxed) };
+}
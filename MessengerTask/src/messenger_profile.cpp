@@ -0,0 +1,293 @@
+// messenger_profile.cpp : Defines the per-stage latency profiler.
+//
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "messenger_profile.hpp"
+
+#define HISTOGRAM_BUCKETS (32)	// log2 buckets of nanoseconds
+
+namespace
+{
+
+struct thread_events_t
+{
+	uint32_t thread;
+	bool active;						/**< owned by a running thread, guarded by the registry lock */
+	std::atomic<uint64_t> recorded;		/**< total number of events, the ring index is recorded % events_per_thread */
+	std::array<messenger::profile::event_t, messenger::profile::events_per_thread> ring;
+};
+
+struct registry_t
+{
+	std::mutex lock;
+	uint32_t next_thread = 0;
+	std::vector<std::unique_ptr<thread_events_t>> threads;	/**< kept after thread exit until reused by a new thread or dropped by reset */
+};
+
+registry_t& registry()
+{
+	static registry_t instance;
+	return instance;
+}
+
+/**
+	* Claims a buffer for the calling thread and gives it back on thread exit
+	*/
+class thread_slot_t
+{
+private:
+	thread_events_t* events;
+
+public:
+	thread_slot_t()
+	{
+		registry_t& reg = registry();
+		std::lock_guard<std::mutex> guard(reg.lock);
+
+		auto reusable = std::find_if(reg.threads.begin(), reg.threads.end(), [](const auto& thread) { return !thread->active; });
+
+		if (reusable != reg.threads.end())
+		{
+			// events of the exited thread stay collectable until this one overwrites them
+			events = reusable->get();
+		}
+		else
+		{
+			reg.threads.push_back(std::make_unique<thread_events_t>());
+			events = reg.threads.back().get();
+			events->recorded = 0;
+		}
+
+		events->thread = reg.next_thread++;
+		events->active = true;
+	}
+
+	thread_slot_t(const thread_slot_t&) = delete;
+	thread_slot_t& operator=(const thread_slot_t&) = delete;
+
+	~thread_slot_t()
+	{
+		registry_t& reg = registry();
+		std::lock_guard<std::mutex> guard(reg.lock);
+
+		events->active = false;
+	}
+
+	thread_events_t& get()
+	{
+		return *events;
+	}
+};
+
+thread_events_t& this_thread_events()
+{
+	thread_local thread_slot_t slot;
+
+	return slot.get();
+}
+
+/**
+	* Restores flags and precision of a stream on scope exit
+	*/
+class format_guard_t
+{
+private:
+	std::ostream& out;
+	std::ios_base::fmtflags flags;
+	std::streamsize precision;
+
+public:
+	format_guard_t(std::ostream& out)
+		: out(out)
+		, flags(out.flags())
+		, precision(out.precision())
+	{}
+
+	format_guard_t(const format_guard_t&) = delete;
+	format_guard_t& operator=(const format_guard_t&) = delete;
+
+	~format_guard_t()
+	{
+		out.flags(flags);
+		out.precision(precision);
+	}
+};
+
+}	// namespace
+
+const char* messenger::profile::stage_name(stage_t stage)
+{
+	switch (stage)
+	{
+	case stage_t::header:			return "header";
+	case stage_t::payload:			return "payload";
+	case stage_t::crc:				return "crc";
+	case stage_t::text_splitter:	return "text_splitter";
+	case stage_t::packet_splitter:	return "packet_splitter";
+	default:						return "unknown";
+	}
+}
+
+uint64_t messenger::profile::now()
+{
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+double messenger::profile::ticks_per_us()
+{
+	static const double ratio = []()
+	{
+		auto clock_start = std::chrono::steady_clock::now();
+		uint64_t ticks_start = now();
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+		uint64_t ticks_end = now();
+		auto clock_end = std::chrono::steady_clock::now();
+
+		double us = std::chrono::duration<double, std::micro>(clock_end - clock_start).count();
+		return (ticks_end - ticks_start) / us;
+	}();
+
+	return ratio;
+}
+
+void messenger::profile::record(stage_t stage, uint64_t start, uint64_t end)
+{
+	thread_events_t& events = this_thread_events();
+	uint64_t index = events.recorded.load(std::memory_order_relaxed);
+
+	events.ring[index % events_per_thread] = { start, end, events.thread, stage };
+	events.recorded.store(index + 1, std::memory_order_release);
+}
+
+std::vector<messenger::profile::event_t> messenger::profile::collect()
+{
+	std::vector<event_t> events;
+
+	registry_t& reg = registry();
+	std::lock_guard<std::mutex> guard(reg.lock);
+
+	for (const auto& thread : reg.threads)
+	{
+		uint64_t recorded = thread->recorded.load(std::memory_order_acquire);
+		uint64_t first = recorded > events_per_thread ? recorded - events_per_thread : 0;
+
+		for (uint64_t index = first; index != recorded; index++)
+		{
+			events.push_back(thread->ring[index % events_per_thread]);
+		}
+	}
+
+	std::sort(events.begin(), events.end(), [](const event_t& a, const event_t& b) { return a.start < b.start; });
+
+	return events;
+}
+
+void messenger::profile::reset()
+{
+	registry_t& reg = registry();
+	std::lock_guard<std::mutex> guard(reg.lock);
+
+	// buffers of exited threads are freed, the running threads keep theirs
+	std::erase_if(reg.threads, [](const auto& thread) { return !thread->active; });
+
+	for (const auto& thread : reg.threads)
+	{
+		thread->recorded.store(0, std::memory_order_release);
+	}
+}
+
+void messenger::profile::write_histograms(std::ostream& out, const std::vector<event_t>& events)
+{
+	format_guard_t guard(out);
+	double ns_per_tick = 1000.0 / ticks_per_us();
+
+	for (size_t stage = 0; stage != static_cast<size_t>(stage_t::count); stage++)
+	{
+		std::vector<double> durations;
+
+		for (const event_t& event : events)
+		{
+			if (static_cast<size_t>(event.stage) == stage) durations.push_back((event.end - event.start) * ns_per_tick);
+		}
+
+		out << stage_name(static_cast<stage_t>(stage)) << ": " << durations.size() << " events";
+
+		if (durations.empty())
+		{
+			out << "\n\n";
+			continue;
+		}
+
+		std::sort(durations.begin(), durations.end());
+
+		auto percentile = [&](double p) { return durations[static_cast<size_t>(p * (durations.size() - 1))]; };
+
+		out << std::fixed << std::setprecision(1)
+			<< ", min " << durations.front() << " ns"
+			<< ", p50 " << percentile(0.5) << " ns"
+			<< ", p99 " << percentile(0.99) << " ns"
+			<< ", max " << durations.back() << " ns\n";
+
+		std::array<size_t, HISTOGRAM_BUCKETS> buckets{};
+
+		for (double duration : durations)
+		{
+			size_t bucket = 0;
+			while (bucket + 1 < HISTOGRAM_BUCKETS && duration >= static_cast<double>(2ull << bucket)) bucket++;
+			buckets[bucket]++;
+		}
+
+		size_t widest = *std::max_element(buckets.begin(), buckets.end());
+
+		for (size_t bucket = 0; bucket != HISTOGRAM_BUCKETS; bucket++)
+		{
+			if (buckets[bucket] == 0) continue;
+
+			out << "  < " << std::setw(10) << (2ull << bucket) << " ns | "
+				<< std::string(1 + buckets[bucket] * 49 / widest, '#') << " " << buckets[bucket] << "\n";
+		}
+
+		out << "\n";
+	}
+}
+
+void messenger::profile::write_chrome_trace(std::ostream& out, const std::vector<event_t>& events)
+{
+	format_guard_t guard(out);
+	double us_per_tick = 1.0 / ticks_per_us();
+	uint64_t origin = events.empty() ? 0 : events.front().start;
+
+	out << "{\"traceEvents\":[";
+
+	for (size_t i = 0; i != events.size(); i++)
+	{
+		const event_t& event = events[i];
+
+		out << (i ? ",\n" : "\n")
+			<< std::fixed << std::setprecision(3)
+			<< "{\"name\":\"" << stage_name(event.stage) << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << event.thread
+			<< ",\"ts\":" << (event.start - origin) * us_per_tick
+			<< ",\"dur\":" << (event.end - event.start) * us_per_tick << "}";
+	}
+
+	out << "\n]}\n";
+}
@@ -0,0 +1,321 @@
+// messenger_shm.cpp : Defines the shared memory channel.
+//
+#include <atomic>
+#include <climits>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "messenger_shm.hpp"
+
+#define RING_MAGIC (0x4d534752494e4731ull)	// "MSGRING1"
+#define CACHE_LINE (64)						// in bytes
+
+#define RECORD_ALIGN (8)					// in bytes
+#define RECORD_LEN_SIZE (4)					// in bytes
+#define RECORD_PADDING (0xffffffffu)		// LEN value of the record filling the end of the ring
+
+#define SPIN_COUNT (1024)					// checks before going to sleep
+
+struct messenger::shm_channel::ring_t
+{
+	std::atomic<uint64_t> magic;	/**< set last, once the ring is initialized */
+	uint64_t capacity;				/**< size of the data area in bytes */
+
+	alignas(CACHE_LINE) std::atomic<uint64_t> head;	/**< written by the producer only */
+	alignas(CACHE_LINE) std::atomic<uint64_t> tail;	/**< written by the consumer only */
+
+	alignas(CACHE_LINE) std::atomic<uint32_t> data_seq;		/**< futex word the consumer sleeps on */
+	std::atomic<uint32_t> consumer_waiting;
+
+	alignas(CACHE_LINE) std::atomic<uint32_t> space_seq;	/**< futex word the producer sleeps on */
+	std::atomic<uint32_t> producer_waiting;
+};
+
+static size_t align_record(size_t size)
+{
+	return (size + RECORD_ALIGN - 1) & ~static_cast<size_t>(RECORD_ALIGN - 1);
+}
+
+static size_t record_space(uint64_t head, size_t capacity, size_t record_size)
+{
+	// a record that does not fit before the end of the ring first needs the rest skipped, then its own size at offset 0
+	size_t contiguous = capacity - head % capacity;
+
+	return record_size <= contiguous ? record_size : contiguous;
+}
+
+static void futex_wait(std::atomic<uint32_t>& word, uint32_t expected)
+{
+	// no FUTEX_PRIVATE_FLAG: the word is shared between processes
+	syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT, expected, nullptr, nullptr, 0);
+}
+
+static void futex_wake(std::atomic<uint32_t>& word)
+{
+	syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+static void notify(std::atomic<uint32_t>& seq, std::atomic<uint32_t>& waiting)
+{
+	seq.fetch_add(1);
+
+	if (waiting.load()) futex_wake(seq);
+}
+
+template <typename Ready>
+static void wait_until(std::atomic<uint32_t>& seq, std::atomic<uint32_t>& waiting, Ready ready)
+{
+	for (int spin = 0; spin < SPIN_COUNT; spin++)
+	{
+		if (ready()) return;
+	}
+
+	while (!ready())
+	{
+		// announce the sleep before the last check, so that notify either sees it or the check sees the update
+		waiting.store(1);
+		uint32_t seq_val = seq.load();
+
+		if (!ready()) futex_wait(seq, seq_val);
+
+		waiting.store(0);
+	}
+}
+
+messenger::shm_channel::shm_channel(const std::string& name, size_t capacity)
+	: name(name)
+	, owner(true)
+	, segment(nullptr)
+	, segment_size(0)
+	, ring(nullptr)
+	, data(nullptr)
+	, pending(0)
+{
+	capacity = align_record(capacity);
+	if (capacity < 2 * RECORD_ALIGN) throw std::length_error("error: channel capacity is too small");
+
+	int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+	if (fd == -1) throw std::system_error(errno, std::generic_category(), "error: shm_open failed");
+
+	size_t size = align_record(sizeof(ring_t)) + capacity;
+
+	if (ftruncate(fd, size) == -1)
+	{
+		int error = errno;
+		close(fd);
+		shm_unlink(name.c_str());
+		throw std::system_error(error, std::generic_category(), "error: ftruncate failed");
+	}
+
+	try
+	{
+		map(fd, size);
+	}
+	catch (...)
+	{
+		shm_unlink(name.c_str());
+		throw;
+	}
+
+	ring = new (segment) ring_t();
+	ring->capacity = capacity;
+	ring->magic.store(RING_MAGIC, std::memory_order_release);
+}
+
+messenger::shm_channel::shm_channel(const std::string& name)
+	: name(name)
+	, owner(false)
+	, segment(nullptr)
+	, segment_size(0)
+	, ring(nullptr)
+	, data(nullptr)
+	, pending(0)
+{
+	int fd = shm_open(name.c_str(), O_RDWR, 0);
+	if (fd == -1) throw std::system_error(errno, std::generic_category(), "error: shm_open failed");
+
+	struct stat info;
+
+	if (fstat(fd, &info) == -1)
+	{
+		int error = errno;
+		close(fd);
+		throw std::system_error(error, std::generic_category(), "error: fstat failed");
+	}
+
+	if (static_cast<size_t>(info.st_size) < align_record(sizeof(ring_t)) + 2 * RECORD_ALIGN)
+	{
+		close(fd);
+		throw std::runtime_error("error: not a messenger channel");
+	}
+
+	map(fd, info.st_size);
+
+	ring = static_cast<ring_t*>(segment);
+
+	if (ring->magic.load(std::memory_order_acquire) != RING_MAGIC || align_record(sizeof(ring_t)) + ring->capacity != segment_size)
+	{
+		munmap(segment, segment_size);
+		throw std::runtime_error("error: not a messenger channel");
+	}
+}
+
+void messenger::shm_channel::map(int fd, size_t size)
+{
+	segment = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	int error = errno;
+
+	close(fd);
+
+	if (segment == MAP_FAILED) throw std::system_error(error, std::generic_category(), "error: mmap failed");
+
+	segment_size = size;
+	data = static_cast<uint8_t*>(segment) + align_record(sizeof(ring_t));
+}
+
+messenger::shm_channel::~shm_channel()
+{
+	munmap(segment, segment_size);
+
+	if (owner) shm_unlink(name.c_str());
+}
+
+bool messenger::shm_channel::try_send(const msg_t& msg)
+{
+	size_t capacity = ring->capacity;
+	size_t size = detail::buff_size(msg.name, msg.text);
+	size_t record_size = align_record(RECORD_LEN_SIZE + size);
+
+	if (record_size > capacity) throw std::length_error("error: message is too long for the channel");
+
+	uint64_t head = ring->head.load(std::memory_order_relaxed);
+	uint64_t tail = ring->tail.load(std::memory_order_acquire);
+
+	size_t offset = head % capacity;
+	size_t contiguous = capacity - offset;
+
+	if (capacity - (head - tail) < record_space(head, capacity, record_size)) return false;
+
+	// records never wrap, the rest of the ring is skipped by a padding record published on its own,
+	// so that the record does not need both at once
+	if (record_size > contiguous)
+	{
+		uint32_t padding = RECORD_PADDING;
+		std::memcpy(data + offset, &padding, RECORD_LEN_SIZE);
+
+		head += contiguous;
+		offset = 0;
+
+		ring->head.store(head);
+		notify(ring->data_seq, ring->consumer_waiting);
+
+		if (capacity - (head - tail) < record_size) return false;
+	}
+
+	// the record becomes visible to the consumer only when head is published, so a failed encoding leaves no trace
+	span_sink sink(std::span<uint8_t>(data + offset + RECORD_LEN_SIZE, size));
+	make_buff(msg, sink);
+
+	uint32_t len = static_cast<uint32_t>(size);
+	std::memcpy(data + offset, &len, RECORD_LEN_SIZE);
+
+	ring->head.store(head + record_size);
+	notify(ring->data_seq, ring->consumer_waiting);
+
+	return true;
+}
+
+void messenger::shm_channel::send(const msg_t& msg)
+{
+	size_t capacity = ring->capacity;
+	size_t record_size = align_record(RECORD_LEN_SIZE + detail::buff_size(msg.name, msg.text));
+
+	while (!try_send(msg))
+	{
+		// wait for the space the record needs rather than for a tail change: the consumer may have freed it since try_send looked
+		uint64_t head = ring->head.load(std::memory_order_relaxed);
+		size_t needed = record_space(head, capacity, record_size);
+
+		wait_until(ring->space_seq, ring->producer_waiting, [&]() { return capacity - (head - ring->tail.load()) >= needed; });
+	}
+}
+
+std::span<const uint8_t> messenger::shm_channel::peek()
+{
+	size_t capacity = ring->capacity;
+
+	uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+	uint64_t head = ring->head.load(std::memory_order_acquire);
+
+	if (tail == head) return {};
+
+	size_t offset = tail % capacity;
+	uint32_t len;
+	std::memcpy(&len, data + offset, RECORD_LEN_SIZE);
+
+	if (len == RECORD_PADDING)
+	{
+		tail += capacity - offset;
+		ring->tail.store(tail);
+		notify(ring->space_seq, ring->producer_waiting);
+
+		if (tail == head) return {};
+
+		offset = 0;
+		std::memcpy(&len, data, RECORD_LEN_SIZE);
+	}
+
+	// written by the other process, must not point outside the ring
+	if (len == 0 || len > capacity - offset - RECORD_LEN_SIZE) throw std::runtime_error("error: corrupted channel record");
+
+	pending = align_record(RECORD_LEN_SIZE + len);
+
+	return { data + offset + RECORD_LEN_SIZE, len };
+}
+
+std::span<const uint8_t> messenger::shm_channel::wait()
+{
+	while (true)
+	{
+		std::span<const uint8_t> buff = peek();
+		if (!buff.empty()) return buff;
+
+		wait_until(ring->data_seq, ring->consumer_waiting, [&]() { return ring->head.load() != ring->tail.load(std::memory_order_relaxed); });
+	}
+}
+
+void messenger::shm_channel::release()
+{
+	if (pending == 0) return;
+
+	ring->tail.store(ring->tail.load(std::memory_order_relaxed) + pending);
+	pending = 0;
+
+	notify(ring->space_seq, ring->producer_waiting);
+}
+
+messenger::msg_t messenger::shm_channel::receive()
+{
+	std::span<const uint8_t> buff = wait();
+
+	try
+	{
+		msg_t msg = parse_buff(buff);
+		release();
+		return msg;
+	}
+	catch (...)
+	{
+		release();
+		throw;
+	}
+}
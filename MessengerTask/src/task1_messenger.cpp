@@ -6,27 +6,53 @@
 #include <string_view>
 
 #include "task1_messenger.hpp"
+#include "messenger_lz.hpp"
+#include "messenger_profile.hpp"
 
 #define CRCPP_INCLUDE_ESOTERIC_CRC_DEFINITIONS
 #include "CRC.h"
 
 #define FLAG_LEN (3)		// in bits
 #define FLAG_VAL (0b101)
+#define FLAG_COMPRESSED_VAL (0b110)	// MSG fields of all packets together hold a messenger::lz block
 
 #define NAMELEN_LEN (4)		// in bits
-#define MAX_NAME_LEN (15)	// in bytes
+#define MAX_NAME_LEN (messenger::detail::max_name_len)	// in bytes
 
 #define TEXTLEN_LEN (5)		// in bits
-#define MAX_MSG_LEN (31)	// in bytes
+#define MAX_MSG_LEN (messenger::detail::max_msg_len)	// in bytes
 
 #define CRC_LEN (4)			// in bits
 #define CRC_MASK (0b1111)
 #define CRC_PLACEHOLDER (0b0000)
 
-#define HEADER_SIZE (2)		// in bytes
+#define HEADER_SIZE (messenger::detail::header_size)	// in bytes
+#define MAX_PACKET_SIZE (messenger::detail::max_packet_size)	// in bytes
 
 #define N_BIT_MASK(num) (0xffff >> (16 - num))
 
+template <typename Parameters>
+static uint8_t calculate_crc4(const void* data, size_t size, const Parameters& parameters)
+{
+	MESSENGER_PROFILE_SCOPE(crc);
+
+	return CRC::Calculate(data, size, parameters);
+}
+
+// crc4 of a packet as if its crc field were cleared, the packet itself is left intact
+static uint8_t packet_crc4(const uint8_t* packet, size_t packet_size)
+{
+	MESSENGER_PROFILE_SCOPE(crc);
+
+	uint8_t header_l = packet[1] & ~N_BIT_MASK(CRC_LEN);
+
+	// continued over the three pieces, so the packet is not copied just to clear its crc field
+	uint8_t crc4 = CRC::Calculate(static_cast<const void*>(packet), 1, CRC::CRC_4_ITU());
+	crc4 = CRC::Calculate(static_cast<const void*>(&header_l), 1, CRC::CRC_4_ITU(), crc4);
+
+	return CRC::Calculate(static_cast<const void*>(packet + HEADER_SIZE), packet_size - HEADER_SIZE, CRC::CRC_4_ITU(), crc4);
+}
+
 class Header 
 {
 private:
@@ -56,17 +82,22 @@ private:
 	}
 
 public:
-	Header(uint8_t namelen, uint8_t msglen)
-		: flag(FLAG_VAL)
+	Header(uint8_t namelen, uint8_t msglen, uint8_t flag = FLAG_VAL)
+		: flag(flag)
 		, namelen(namelen)
 		, msglen(msglen)
 		, crc4(0)
 	{
+		MESSENGER_PROFILE_SCOPE(header);
+
 		update_header();
 	}
 
-	Header(std::vector<uint8_t>::const_iterator header_iter)
+	template <typename ByteIter>
+	Header(ByteIter header_iter)
 	{
+		MESSENGER_PROFILE_SCOPE(header);
+
 		uint16_t header = (static_cast<unsigned short>(*header_iter) << __CHAR_BIT__) + (static_cast<unsigned short>(*(header_iter + 1)));
 
 		crc4 = header & N_BIT_MASK(CRC_LEN);
@@ -83,7 +114,7 @@ public:
 
 		update_header();
 
-		if (flag != FLAG_VAL) throw std::runtime_error("error: invalid flag");
+		if (flag != FLAG_VAL && flag != FLAG_COMPRESSED_VAL) throw std::runtime_error("error: invalid flag");
 	}
 
 	uint8_t size() 
@@ -101,6 +132,11 @@ public:
 		return static_cast<uint8_t>(header & N_BIT_MASK(__CHAR_BIT__));
 	}
 
+	uint8_t get_flag()
+	{
+		return flag;
+	}
+
 	uint8_t get_namelen()
 	{
 		return namelen;
@@ -123,6 +159,34 @@ public:
 	}
 };
 
+// header, NAME and MSG of one packet written to out, then the crc field computed over them; lengths are checked by the caller
+static uint8_t write_packet(Header& header, std::string_view name, std::string_view msg, uint8_t* out)
+{
+	header.set_crc(CRC_PLACEHOLDER);
+
+	out[0] = header.get_header_h();
+	out[1] = header.get_header_l();
+
+	uint8_t* msg_out = std::copy(name.begin(), name.end(), out + header.size());
+	std::copy(msg.begin(), msg.end(), msg_out);
+
+	uint8_t packet_size = header.size() + name.size() + msg.size();
+
+	// update the crc value in the header(previously there was a CRC_PLACEHOLDER)
+	header.set_crc(
+		calculate_crc4(
+			static_cast<void*>(out),	// pointer to data
+			packet_size,				// size of data
+			CRC::CRC_4_ITU()			// crc formula
+		)
+	);
+
+	// update the crc field of the header in the current packet
+	out[1] = header.get_header_l();
+
+	return packet_size;
+}
+
 class Payload 
 {
 private:
@@ -139,6 +203,8 @@ public:
 
 	void set_name(std::string name) 
 	{
+		MESSENGER_PROFILE_SCOPE(payload);
+
 		if (name.empty()) throw std::length_error("error: name cannot be empty");
 		if (name.size() > MAX_NAME_LEN) throw std::length_error("error: name is too long");
 
@@ -147,11 +213,15 @@ public:
 
 	void set_name(std::vector<uint8_t>::const_iterator name_begin, std::vector<uint8_t>::const_iterator name_end) 
 	{
+		MESSENGER_PROFILE_SCOPE(payload);
+
 		name.assign(name_begin, name_end);
 	}
 
 	void set_message(std::string_view::const_iterator msg_begin, std::string_view::const_iterator msg_end) 
 	{
+		MESSENGER_PROFILE_SCOPE(payload);
+
 		if (std::distance(msg_begin, msg_end) > MAX_MSG_LEN) throw std::length_error("error: message is too long");
 		if (msg_end == msg_begin) throw std::length_error("error: message cannot be empty");
 
@@ -160,6 +230,8 @@ public:
 
 	void set_message(std::vector<uint8_t>::const_iterator msg_begin, std::vector<uint8_t>::const_iterator msg_end) 
 	{
+		MESSENGER_PROFILE_SCOPE(payload);
+
 		message.assign(msg_begin, msg_end);
 	}
 
@@ -190,19 +262,9 @@ private:
 	Header header;
 	Payload payload;
 
-	void set_buff_crc(std::vector<uint8_t>& buff) 
-	{
-		buff[1] |= header.get_crc4();
-	}
-
-	void clear_buff_crc(std::vector<uint8_t>::iterator header_iter) 
-	{
-		*(header_iter + 1) &= ~N_BIT_MASK(CRC_LEN);
-	}
-
 public:
-	Packet(std::string name, std::string_view::const_iterator msg_begin, std::string_view::const_iterator msg_end)
-		: header(name.size(), std::distance(msg_begin, msg_end))
+	Packet(std::string name, std::string_view::const_iterator msg_begin, std::string_view::const_iterator msg_end, uint8_t flag = FLAG_VAL)
+		: header(name.size(), std::distance(msg_begin, msg_end), flag)
 	{
 
 		payload.set_name(name);
@@ -216,18 +278,10 @@ public:
 		auto name_start = header_start + header.size();
 		auto msg_start = name_start + header.get_namelen();
 
-		clear_buff_crc(header_start);
-
 		payload.set_name(name_start, name_start + header.get_namelen());
 		payload.set_message(msg_start, msg_start + header.get_msglen());
 
-		uint8_t calculated_crc4 = CRC::Calculate(
-			static_cast<void*>(&*header_start), // pointer to data
-			this->size(),						// size of the data
-			CRC::CRC_4_ITU()					// crc formula
-		);
-
-		if (calculated_crc4 != header.get_crc4()) throw std::runtime_error("error: invalid crc");
+		if (packet_crc4(&*header_start, this->size()) != header.get_crc4()) throw std::runtime_error("error: invalid crc");
 	}
 
 	uint8_t size()
@@ -235,6 +289,11 @@ public:
 		return header.size() + payload.size();
 	}
 
+	bool is_compressed()
+	{
+		return header.get_flag() == FLAG_COMPRESSED_VAL;
+	}
+
 	std::string get_name() 
 	{
 		return std::string(payload.name_begin(), payload.name_end());
@@ -245,27 +304,26 @@ public:
 		return std::string(payload.msg_begin(), payload.msg_end());
 	}
 
-	std::vector<uint8_t>bufferize() 
+	/**
+	* Write the packet to out (at least size() bytes)
+	*
+	* @return size of the packet
+	*/
+	uint8_t serialize(uint8_t* out) 
 	{
-		std::vector<uint8_t> packet;
-
-		packet.push_back(header.get_header_h());	
-		packet.push_back(header.get_header_l());	
-
-		packet.insert(packet.end(), payload.name_begin(), payload.name_end());
-		packet.insert(packet.end(), payload.msg_begin(), payload.msg_end());
-
-		// update the crc value in the header(previously there was a CRC_PLACEHOLDER)
-		header.set_crc(
-			CRC::Calculate(
-				static_cast<void*>(&packet[0]), // pointer to data
-				this->size(),					// size of data
-				CRC::CRC_4_ITU()				// crc formula
-			)
+		return write_packet(
+			header,
+			std::string_view(payload.name_begin(), payload.name_end()),
+			std::string_view(payload.msg_begin(), payload.msg_end()),
+			out
 		);
+	}
+
+	std::vector<uint8_t>bufferize() 
+	{
+		std::vector<uint8_t> packet(this->size());
 
-		// update the crc field of the heaader in the current packet
-		set_buff_crc(packet);
+		serialize(packet.data());
 
 		return packet;
 	}
@@ -275,6 +333,8 @@ static std::vector<std::string_view> text_splitter(std::string::const_iterator t
 												std::string::const_iterator text_end, 
 												uint8_t split_length) 
 {
+	MESSENGER_PROFILE_SCOPE(text_splitter);
+
 	std::vector<std::string_view> texts;
 
 	std::string::const_iterator start = text_begin;
@@ -286,7 +346,7 @@ static std::vector<std::string_view> text_splitter(std::string::const_iterator t
 			start = end;
 		}
 
-		end += std::min(split_length, static_cast<uint8_t>(text_end - start));
+		end += std::min(static_cast<std::ptrdiff_t>(split_length), std::distance(end, text_end));
 	}
 
 	texts.push_back({ start, end }); // insert the last packet when end == text_end
@@ -294,16 +354,16 @@ static std::vector<std::string_view> text_splitter(std::string::const_iterator t
 	return texts;
 }
 
-std::vector<uint8_t> messenger::make_buff(const messenger::msg_t& msg)
+static std::vector<uint8_t> make_packets(const std::string& name, const std::string& full_text, uint8_t flag)
 {
-	std::vector<std::string_view> msgs_list = text_splitter(msg.text.cbegin(), msg.text.cend(), MAX_MSG_LEN);
+	std::vector<std::string_view> msgs_list = text_splitter(full_text.cbegin(), full_text.cend(), MAX_MSG_LEN);
 
 	std::vector<uint8_t> res_buff;
 	std::vector<uint8_t> single_packet_buff;
 
 	for (std::string_view text : msgs_list) 
 	{
-		Packet single_packet(msg.name, text.cbegin(), text.cend());								
+		Packet single_packet(name, text.cbegin(), text.cend(), flag);							
 		single_packet_buff = single_packet.bufferize();											
 		res_buff.insert(res_buff.end(), single_packet_buff.cbegin(), single_packet_buff.cend());
 	}
@@ -311,9 +371,28 @@ std::vector<uint8_t> messenger::make_buff(const messenger::msg_t& msg)
 	return res_buff;
 }
 
+std::vector<uint8_t> messenger::make_buff(const messenger::msg_t& msg)
+{
+	return make_packets(msg.name, msg.text, FLAG_VAL);
+}
+
+std::vector<uint8_t> messenger::make_compressed_buff(const messenger::msg_t& msg)
+{
+	if (msg.text.empty()) throw std::length_error("error: message cannot be empty");
+
+	std::string block = messenger::lz::compress(msg.text);
+
+	// incompressible text is cheaper to send as is
+	if (block.size() >= msg.text.size()) return make_packets(msg.name, msg.text, FLAG_VAL);
+
+	return make_packets(msg.name, block, FLAG_COMPRESSED_VAL);
+}
+
 static std::vector<Packet> packet_splitter(std::vector<uint8_t>::iterator buff_begin,
 	std::vector<uint8_t>::iterator buff_end)
 {
+	MESSENGER_PROFILE_SCOPE(packet_splitter);
+
 	std::vector<Packet> packets;
 
 	while (buff_begin != buff_end) 
@@ -338,8 +417,162 @@ messenger::msg_t messenger::parse_buff(std::vector<uint8_t>& buff)
 	// set message
 	for (auto packet : packets_list) 
 	{
+		if (packet.is_compressed() != packets_list[0].is_compressed()) throw std::runtime_error("error: invalid flag");
+
 		msg.text += packet.get_message();
 	}
 
+	if (packets_list[0].is_compressed()) msg.text = messenger::lz::decompress(msg.text);
+
 	return msg;
-}
\ No newline at end of file
+}
+
+messenger::msg_batch_t messenger::parse_batch(const std::vector<std::vector<uint8_t>>& buffs)
+{
+	messenger::msg_batch_t batch;
+
+	batch.name_offsets.reserve(buffs.size() + 1);
+	batch.text_offsets.reserve(buffs.size() + 1);
+	batch.name_lens.reserve(buffs.size());
+	batch.packet_counts.reserve(buffs.size());
+
+	batch.name_offsets.push_back(0);
+	batch.text_offsets.push_back(0);
+
+	std::string block;	// reused by every compressed buffer
+
+	for (const std::vector<uint8_t>& buff : buffs) 
+	{
+		std::span<const uint8_t> view(buff);
+
+		size_t text_start = batch.texts.size();
+		uint32_t packet_count = 0;
+
+		// one pass over the buffer: every packet is verified and appended as soon as its header is read
+		bool compressed = messenger::detail::for_each_packet(view, [&](const messenger::detail::packet_ref_t& packet)
+		{
+			messenger::detail::verify_packet(view, packet);
+
+			// the sender name is taken from the first packet, as in parse_buff
+			if (packet_count == 0) 
+			{
+				std::string_view name = messenger::detail::packet_name(view, packet);
+
+				batch.names.insert(batch.names.end(), name.begin(), name.end());
+				batch.name_lens.push_back(packet.name_len);
+			}
+
+			std::string_view msg = messenger::detail::packet_msg(view, packet);
+			batch.texts.insert(batch.texts.end(), msg.begin(), msg.end());
+
+			packet_count++;
+		});
+
+		if (compressed) 
+		{
+			// the block may be empty (MSG_LEN 0 packets), so it is addressed through data() rather than an iterator
+			block.assign(batch.texts.data() + text_start, batch.texts.size() - text_start);
+
+			batch.texts.resize(text_start + messenger::lz::decompressed_size(block));
+			messenger::lz::decompress(block, batch.texts.data() + text_start, batch.texts.size() - text_start);
+		}
+
+		if (batch.names.size() > UINT32_MAX || batch.texts.size() > UINT32_MAX) throw std::length_error("error: batch is too large");
+
+		batch.name_offsets.push_back(static_cast<uint32_t>(batch.names.size()));
+		batch.text_offsets.push_back(static_cast<uint32_t>(batch.texts.size()));
+		batch.packet_counts.push_back(packet_count);
+	}
+
+	return batch;
+}
+
+size_t messenger::detail::buff_size(std::string_view name, std::string_view text)
+{
+	size_t packet_count = std::max<size_t>(1, (text.size() + MAX_MSG_LEN - 1) / MAX_MSG_LEN);
+
+	return packet_count * (HEADER_SIZE + name.size()) + text.size();
+}
+
+size_t messenger::detail::next_packet_size(std::string_view name, std::string_view text)
+{
+	if (name.empty()) throw std::length_error("error: name cannot be empty");
+	if (name.size() > MAX_NAME_LEN) throw std::length_error("error: name is too long");
+	if (text.empty()) throw std::length_error("error: message cannot be empty");
+
+	return HEADER_SIZE + name.size() + std::min<size_t>(text.size(), MAX_MSG_LEN);
+}
+
+size_t messenger::detail::encode_packet(std::string_view name, std::string_view& text, uint8_t* out)
+{
+	next_packet_size(name, text);	// validates name and message lengths
+
+	std::string_view chunk = text.substr(0, MAX_MSG_LEN);
+	text.remove_prefix(chunk.size());
+
+	Header header(name.size(), chunk.size());
+
+	return write_packet(header, name, chunk, out);
+}
+
+std::string_view messenger::detail::peek_sender(std::span<const uint8_t> buff)
+{
+	if (buff.size() < HEADER_SIZE) throw std::runtime_error("error: truncated packet");
+
+	Header header(buff.data());
+
+	if (buff.size() - header.size() < header.get_namelen()) throw std::runtime_error("error: truncated packet");
+
+	return std::string_view(reinterpret_cast<const char*>(buff.data() + header.size()), header.get_namelen());
+}
+
+messenger::detail::packet_ref_t messenger::detail::read_packet(std::span<const uint8_t> buff, size_t pos)
+{
+	if (buff.size() - pos < HEADER_SIZE) throw std::runtime_error("error: truncated packet");
+
+	Header header(buff.data() + pos);
+
+	messenger::detail::packet_ref_t packet{ pos, header.get_namelen(), header.get_msglen(), header.get_crc4(), header.get_flag() == FLAG_COMPRESSED_VAL };
+
+	if (buff.size() - pos < packet_size(packet)) throw std::runtime_error("error: truncated packet");
+
+	return packet;
+}
+
+void messenger::detail::verify_packet(std::span<const uint8_t> buff, const packet_ref_t& packet)
+{
+	if (packet_crc4(buff.data() + packet.offset, packet_size(packet)) != packet.crc4) throw std::runtime_error("error: invalid crc");
+}
+
+messenger::detail::buff_layout_t messenger::detail::scan_buff(std::span<const uint8_t> buff)
+{
+	messenger::detail::buff_layout_t layout{ std::string_view(), 0, false, {} };
+
+	layout.compressed = for_each_packet(buff, [&](const messenger::detail::packet_ref_t& packet)
+	{
+		if (layout.packets.empty()) layout.name = packet_name(buff, packet);
+
+		layout.text_size += packet.msg_len;
+		layout.packets.push_back(packet);
+	});
+
+	return layout;
+}
+
+void messenger::detail::verify_buff(std::span<const uint8_t> buff, const buff_layout_t& layout)
+{
+	for (const messenger::detail::packet_ref_t& packet : layout.packets) 
+	{
+		verify_packet(buff, packet);
+	}
+}
+
+void messenger::detail::gather_text(std::span<const uint8_t> buff, const buff_layout_t& layout, char* out)
+{
+	for (const messenger::detail::packet_ref_t& packet : layout.packets) 
+	{
+		std::string_view msg = packet_msg(buff, packet);
+
+		out = std::copy(msg.begin(), msg.end(), out);
+	}
+}
@@ -0,0 +1,95 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "task1_messenger.hpp"
+#include "messenger_cache.hpp"
+
+TEST_CASE("ParseCache_HitAfterMiss", "ParseCache")
+{
+	std::string name("Elyorbek");
+	std::string text("this message contains 62 chars,this message contains 62 chars ");
+
+	const std::vector<uint8_t> buff = messenger::make_buff(messenger::msg_t(name, text));
+
+	messenger::parse_cache cache(16);
+
+	const messenger::msg_t& message1 = cache.parse(buff);
+	const messenger::msg_t& message2 = cache.parse(buff);
+
+	REQUIRE(message1.name == name);
+	REQUIRE(message1.text == text);
+	REQUIRE(message2.name == name);
+	REQUIRE(message2.text == text);
+
+	REQUIRE(cache.stats().misses == 1);
+	REQUIRE(cache.stats().hits == 1);
+	REQUIRE(cache.size() == 1);
+
+	REQUIRE(buff == messenger::make_buff(messenger::msg_t(name, text))); // buffer is left unmodified
+}
+
+TEST_CASE("ParseCache_DifferentBuffers", "ParseCache")
+{
+	std::vector<uint8_t> buff1 = messenger::make_buff(messenger::msg_t("Elyorbek", "Hi"));
+	std::vector<uint8_t> buff2 = messenger::make_buff(messenger::msg_t("Timur", "Hi"));
+
+	messenger::parse_cache cache(16);
+
+	REQUIRE(cache.parse(buff1).name == "Elyorbek");
+	REQUIRE(cache.parse(buff2).name == "Timur");
+	REQUIRE(cache.parse(buff1).name == "Elyorbek");
+
+	REQUIRE(cache.stats().misses == 2);
+	REQUIRE(cache.stats().hits == 1);
+}
+
+TEST_CASE("ParseCache_CapacityBound", "ParseCache")
+{
+	messenger::parse_cache cache(4, 1);
+
+	for (char c = 'a'; c <= 'z'; c++)
+	{
+		cache.parse(messenger::make_buff(messenger::msg_t("Elyorbek", std::string(1, c))));
+	}
+
+	REQUIRE(cache.size() == 4);
+
+	// most recent entries survive, the oldest ones are evicted
+	cache.parse(messenger::make_buff(messenger::msg_t("Elyorbek", "z")));
+	cache.parse(messenger::make_buff(messenger::msg_t("Elyorbek", "a")));
+
+	REQUIRE(cache.stats().hits == 1);
+	REQUIRE(cache.stats().misses == 27);
+}
+
+TEST_CASE("ParseCache_WrongCRC", "ParseCache")
+{
+	std::vector<uint8_t> buff = messenger::make_buff(messenger::msg_t("Elyorbek", "Hi"));
+
+	buff[1] &= 0xf0; // clear crc field
+
+	messenger::parse_cache cache(16);
+
+	REQUIRE_THROWS_AS(cache.parse(buff), std::runtime_error);
+	REQUIRE_THROWS_AS(cache.parse(buff), std::runtime_error);
+	REQUIRE(cache.size() == 0);
+}
+
+TEST_CASE("ParseCache_ZeroCapacity", "ParseCache")
+{
+	REQUIRE_THROWS_AS(messenger::parse_cache(0), std::invalid_argument);
+}
+
+TEST_CASE("ParseCache_UnevenCapacity", "ParseCache")
+{
+	messenger::parse_cache cache(15, 8);
+
+	for (int i = 0; i < 500; i++)
+	{
+		cache.parse(messenger::make_buff(messenger::msg_t("Elyorbek", std::to_string(i))));
+	}
+
+	REQUIRE(cache.size() == 15);
+}
@@ -0,0 +1,113 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "task1_messenger.hpp"
+#include "messenger_filter.hpp"
+
+TEST_CASE("SenderFilter_Contains", "SenderFilter")
+{
+	messenger::sender_filter filter({ "E", "Timur", "ElyorbekElyorbe", "Timur" });
+
+	REQUIRE(filter.size() == 3);
+
+	REQUIRE(filter.contains("E") == true);
+	REQUIRE(filter.contains("Timur") == true);
+	REQUIRE(filter.contains("ElyorbekElyorbe") == true);
+
+	REQUIRE(filter.contains("") == false);
+	REQUIRE(filter.contains("Elyorbek") == false);
+	REQUIRE(filter.contains("Timu") == false);
+	REQUIRE(filter.contains("ElyorbekElyorbek") == false);
+	REQUIRE(filter.contains(std::string("E\0", 2)) == false);
+}
+
+TEST_CASE("SenderFilter_Many", "SenderFilter")
+{
+	std::vector<std::string> senders;
+
+	for (int i = 0; i < 1000; i++)
+	{
+		senders.push_back("user" + std::to_string(i));
+	}
+
+	messenger::sender_filter filter(senders);
+
+	bool found_all = true;
+	bool found_other = false;
+
+	for (int i = 0; i < 2000; i++)
+	{
+		bool found = filter.contains("user" + std::to_string(i));
+
+		if (i < 1000 && !found) found_all = false;
+		if (i >= 1000 && found) found_other = true;
+	}
+
+	REQUIRE(found_all == true);
+	REQUIRE(found_other == false);
+}
+
+TEST_CASE("SenderFilter_NameLen16", "SenderFilter")
+{
+	REQUIRE_THROWS_AS(messenger::sender_filter({ "ElyorbekElyorbek" }), std::length_error);
+	REQUIRE_THROWS_AS(messenger::sender_filter({ "" }), std::length_error);
+}
+
+TEST_CASE("ParseFiltered_Match", "ParseFiltered")
+{
+	messenger::sender_filter filter({ "Timur" });
+
+	std::string text("this message contains 62 chars,this message contains 62 chars ");
+	const std::vector<uint8_t> buff = messenger::make_buff(messenger::msg_t("Timur", text));
+
+	std::optional<messenger::msg_t> message = messenger::parse_filtered(std::span<const uint8_t>(buff), filter);
+
+	REQUIRE(message.has_value());
+	REQUIRE(message->name == "Timur");
+	REQUIRE(message->text == text);
+}
+
+TEST_CASE("ParseFiltered_SkipsPayload", "ParseFiltered")
+{
+	messenger::sender_filter filter({ "Timur" });
+
+	std::vector<uint8_t> buff = messenger::make_buff(messenger::msg_t("Elyorbek", "Hi"));
+
+	buff[1] &= 0xf0;	// clear crc field, never checked for other senders
+	buff.pop_back();	// truncated text, never read either
+
+	REQUIRE(messenger::parse_filtered(std::span<const uint8_t>(buff), filter).has_value() == false);
+}
+
+TEST_CASE("ParseFiltered_WrongCRC", "ParseFiltered")
+{
+	messenger::sender_filter filter({ "Timur" });
+
+	std::vector<uint8_t> buff = messenger::make_buff(messenger::msg_t("Timur", "Hi"));
+
+	buff[1] &= 0xf0; // clear crc field
+
+	REQUIRE_THROWS_AS(messenger::parse_filtered(std::span<const uint8_t>(buff), filter), std::runtime_error);
+}
+
+TEST_CASE("ParseFiltered_Batch", "ParseFiltered")
+{
+	messenger::sender_filter filter({ "Timur", "E" });
+
+	std::vector<std::vector<uint8_t>> buffs;
+	buffs.push_back(messenger::make_buff(messenger::msg_t("Elyorbek", "one")));
+	buffs.push_back(messenger::make_buff(messenger::msg_t("Timur", "two")));
+	buffs.push_back(messenger::make_compressed_buff(messenger::msg_t("E", std::string(200, 'z'))));
+	buffs.push_back(messenger::make_buff(messenger::msg_t("Tim", "four")));
+
+	const std::vector<messenger::msg_t>& messages = messenger::parse_filtered(buffs, filter);
+
+	REQUIRE(messages.size() == 2);
+	REQUIRE(messages[0].name == "Timur");
+	REQUIRE(messages[0].text == "two");
+	REQUIRE(messages[1].name == "E");
+	REQUIRE(messages[1].text == std::string(200, 'z'));
+}
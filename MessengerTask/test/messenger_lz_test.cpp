@@ -0,0 +1,104 @@
+#include <catch2/catch_test_macros.hpp>
+#include <stdexcept>
+#include <string>
+
+#include "messenger_lz.hpp"
+
+TEST_CASE("Lz_Empty", "Lz")
+{
+	std::string text("");
+
+	REQUIRE(messenger::lz::decompress(messenger::lz::compress(text)) == text);
+}
+
+TEST_CASE("Lz_Short", "Lz")
+{
+	std::string text("Hi");
+
+	REQUIRE(messenger::lz::decompress(messenger::lz::compress(text)) == text);
+}
+
+TEST_CASE("Lz_Repetitive", "Lz")
+{
+	std::string text;
+
+	for (int i = 0; i < 200; i++)
+	{
+		text += "2024-01-01 12:00:00 INFO link " + std::to_string(i % 7) + " is up\n";
+	}
+
+	std::string block = messenger::lz::compress(text);
+
+	REQUIRE(block.size() * 4 < text.size());
+	REQUIRE(messenger::lz::decompress(block) == text);
+}
+
+TEST_CASE("Lz_LongRun", "Lz")
+{
+	std::string text(100000, 'a');
+	text += "tail";
+
+	REQUIRE(messenger::lz::decompress(messenger::lz::compress(text)) == text);
+}
+
+TEST_CASE("Lz_Binary", "Lz")
+{
+	std::string text;
+
+	for (int i = 0; i < 5000; i++)
+	{
+		text.push_back(static_cast<char>((i * 7919) % 251));
+	}
+
+	REQUIRE(messenger::lz::decompress(messenger::lz::compress(text)) == text);
+}
+
+TEST_CASE("Lz_Truncated", "Lz")
+{
+	std::string block = messenger::lz::compress(std::string(1000, 'a'));
+
+	block.pop_back();
+
+	REQUIRE_THROWS_AS(messenger::lz::decompress(block), std::runtime_error);
+}
+
+TEST_CASE("Lz_WrongOffset", "Lz")
+{
+	std::string block;
+	block.push_back(8);			// text length
+	block.push_back(0x10);		// 1 literal, match of 4
+	block.push_back('a');
+	block.push_back(2);			// offset points before the text start
+	block.push_back(0);
+
+	REQUIRE_THROWS_AS(messenger::lz::decompress(block), std::runtime_error);
+}
+
+TEST_CASE("Lz_WrongTextLen", "Lz")
+{
+	std::string block;
+	block.push_back(static_cast<char>(0xff));	// text length of 2^35 - 1
+	block.push_back(static_cast<char>(0xff));
+	block.push_back(static_cast<char>(0xff));
+	block.push_back(static_cast<char>(0xff));
+	block.push_back(0x7f);
+	block.push_back(0x10);						// 1 literal
+	block.push_back('a');
+
+	REQUIRE_THROWS_AS(messenger::lz::decompressed_size(block), std::runtime_error);
+	REQUIRE_THROWS_AS(messenger::lz::decompress(block), std::runtime_error);
+}
+
+TEST_CASE("Lz_DecompressInto", "Lz")
+{
+	std::string text("link is up, link is up, link is up");
+	std::string block = messenger::lz::compress(text);
+
+	std::string out(messenger::lz::decompressed_size(block), '\0');
+	messenger::lz::decompress(block, out.data(), out.size());
+
+	REQUIRE(out == text);
+
+	char small[4];
+	REQUIRE_THROWS_AS(messenger::lz::decompress(block, small, sizeof(small)), std::runtime_error);
+}
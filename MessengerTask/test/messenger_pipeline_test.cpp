@@ -0,0 +1,163 @@
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/resource.h>
+#endif
+
+#include "task1_messenger.hpp"
+#include "messenger_pipeline.hpp"
+
+TEST_CASE("Pipeline_Order", "Pipeline")
+{
+	std::vector<std::string> texts;
+
+	messenger::receive_pipeline pipeline([&](const messenger::msg_t& msg) { texts.push_back(msg.text); });
+
+	for (int i = 0; i < 10000; i++)
+	{
+		pipeline.push(messenger::make_buff(messenger::msg_t("Elyorbek", "message " + std::to_string(i))));
+	}
+
+	pipeline.finish();
+
+	REQUIRE(texts.size() == 10000);
+	REQUIRE(pipeline.stats().dispatched == 10000);
+	REQUIRE(pipeline.stats().failed == 0);
+
+	bool in_order = true;
+
+	for (int i = 0; i < 10000; i++)
+	{
+		if (texts[i] != "message " + std::to_string(i)) in_order = false;
+	}
+
+	REQUIRE(in_order == true);
+}
+
+TEST_CASE("Pipeline_Errors", "Pipeline")
+{
+	std::vector<std::string> events;
+
+	messenger::receive_pipeline pipeline(
+		[&](const messenger::msg_t& msg) { events.push_back(msg.text); },
+		[&](std::exception_ptr error)
+		{
+			try
+			{
+				std::rethrow_exception(error);
+			}
+			catch (const std::runtime_error& e)
+			{
+				events.push_back(e.what());
+			}
+		});
+
+	std::vector<uint8_t> wrong_flag = messenger::make_buff(messenger::msg_t("Elyorbek", "Hi"));
+	wrong_flag[0] &= 0x1f; // clear flag field
+
+	std::vector<uint8_t> wrong_crc = messenger::make_buff(messenger::msg_t("Elyorbek", "Hi"));
+	wrong_crc[1] ^= 0x01; // corrupt crc field
+
+	pipeline.push(messenger::make_buff(messenger::msg_t("Elyorbek", "first")));
+	pipeline.push(wrong_flag);
+	pipeline.push(wrong_crc);
+	pipeline.push(messenger::make_buff(messenger::msg_t("Elyorbek", "last")));
+	pipeline.finish();
+
+	REQUIRE(events == std::vector<std::string>{ "first", "error: invalid flag", "error: invalid crc", "last" });
+	REQUIRE(pipeline.stats().dispatched == 2);
+	REQUIRE(pipeline.stats().failed == 2);
+}
+
+TEST_CASE("Pipeline_SmallQueues", "Pipeline")
+{
+	messenger::pipeline_config_t config;
+	config.queue_capacity = 2;
+	config.batch_size = 1;
+	config.prefetch = false;
+
+	std::string text(200, 'x');
+	size_t total = 0;
+
+	messenger::receive_pipeline pipeline([&](const messenger::msg_t& msg) { total += msg.text.size(); }, nullptr, config);
+
+	for (int i = 0; i < 1000; i++)
+	{
+		pipeline.push(messenger::make_buff(messenger::msg_t("Elyorbek", text)));
+	}
+
+	pipeline.finish();
+
+	REQUIRE(total == 1000 * text.size());
+}
+
+TEST_CASE("Pipeline_PushAfterFinish", "Pipeline")
+{
+	messenger::receive_pipeline pipeline([](const messenger::msg_t&) {});
+
+	pipeline.finish();
+
+	REQUIRE_THROWS_AS(pipeline.push(messenger::make_buff(messenger::msg_t("Elyorbek", "Hi"))), std::logic_error);
+}
+
+TEST_CASE("Pipeline_HandlerThrows", "Pipeline")
+{
+	messenger::receive_pipeline pipeline([](const messenger::msg_t& msg)
+	{
+		if (msg.text == "odd") throw std::runtime_error("handler");
+	},
+	[](std::exception_ptr) { throw std::runtime_error("error handler"); });
+
+	for (int i = 0; i < 100; i++)
+	{
+		pipeline.push(messenger::make_buff(messenger::msg_t("Elyorbek", i % 2 ? "odd" : "even")));
+	}
+
+	pipeline.push({ 0x00, 0x00 });
+
+	REQUIRE_THROWS_AS(pipeline.finish(), std::runtime_error);
+	REQUIRE_NOTHROW(pipeline.finish());
+
+	messenger::pipeline_stats_t stats = pipeline.stats();
+
+	REQUIRE(stats.dispatched == 50);
+	REQUIRE(stats.failed == 1);
+	REQUIRE(stats.handler_errors == 51);
+}
+
+#ifdef __linux__
+
+TEST_CASE("Pipeline_IdleSleeps", "Pipeline")
+{
+	messenger::receive_pipeline pipeline([](const messenger::msg_t&) {});
+
+	pipeline.push(messenger::make_buff(messenger::msg_t("Elyorbek", "Hi")));
+
+	auto cpu_time = []()
+	{
+		rusage usage;
+		getrusage(RUSAGE_SELF, &usage);
+
+		return std::chrono::seconds(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec)
+			+ std::chrono::microseconds(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec);
+	};
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));	// let the stages drain and fall asleep
+
+	auto cpu_start = cpu_time();
+	std::this_thread::sleep_for(std::chrono::milliseconds(300));
+	auto cpu_used = cpu_time() - cpu_start;
+
+	pipeline.finish();
+
+	REQUIRE(cpu_used < std::chrono::milliseconds(30));
+	REQUIRE(pipeline.stats().dispatched == 1);
+}
+
+#endif // __linux__
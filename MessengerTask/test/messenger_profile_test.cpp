@@ -0,0 +1,102 @@
+#include <catch2/catch_test_macros.hpp>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "task1_messenger.hpp"
+#include "messenger_profile.hpp"
+
+static size_t count_stage(const std::vector<messenger::profile::event_t>& events, messenger::profile::stage_t stage)
+{
+	size_t count = 0;
+
+	for (const messenger::profile::event_t& event : events)
+	{
+		if (event.stage == stage) count++;
+	}
+
+	return count;
+}
+
+TEST_CASE("Profile_AllStages", "Profile")
+{
+	messenger::profile::reset();
+
+	std::vector<uint8_t> buff = messenger::make_buff(messenger::msg_t("Elyorbek", "this message contains 32 chars  "));
+	messenger::parse_buff(buff);
+
+	std::vector<messenger::profile::event_t> events = messenger::profile::collect();
+
+	REQUIRE(count_stage(events, messenger::profile::stage_t::text_splitter) == 1);
+	REQUIRE(count_stage(events, messenger::profile::stage_t::packet_splitter) == 1);
+	REQUIRE(count_stage(events, messenger::profile::stage_t::crc) == 4);		// 2 packets encoded, 2 packets parsed
+	REQUIRE(count_stage(events, messenger::profile::stage_t::header) == 4);
+	REQUIRE(count_stage(events, messenger::profile::stage_t::payload) == 8);
+
+	for (const messenger::profile::event_t& event : events)
+	{
+		REQUIRE(event.start <= event.end);
+	}
+}
+
+TEST_CASE("Profile_Threads", "Profile")
+{
+	messenger::profile::reset();
+
+	std::thread worker([]() { messenger::make_buff(messenger::msg_t("Elyorbek", "Hi")); });
+	worker.join();
+
+	messenger::make_buff(messenger::msg_t("Elyorbek", "Hi"));
+
+	std::vector<messenger::profile::event_t> events = messenger::profile::collect();
+
+	REQUIRE(count_stage(events, messenger::profile::stage_t::crc) == 2);
+	REQUIRE(events.front().thread != events.back().thread);
+}
+
+TEST_CASE("Profile_ExitedThreads", "Profile")
+{
+	messenger::profile::reset();
+
+	for (int i = 0; i < 8; i++)
+	{
+		std::thread worker([]() { messenger::make_buff(messenger::msg_t("Elyorbek", "Hi")); });
+		worker.join();
+	}
+
+	std::vector<messenger::profile::event_t> events = messenger::profile::collect();
+
+	REQUIRE(count_stage(events, messenger::profile::stage_t::crc) == 8);	// buffers are reused, earlier events are kept
+	REQUIRE(events.front().thread != events.back().thread);
+
+	messenger::profile::reset();
+
+	REQUIRE(messenger::profile::collect().empty() == true);
+}
+
+TEST_CASE("Profile_Dump", "Profile")
+{
+	messenger::profile::reset();
+
+	messenger::make_buff(messenger::msg_t("Elyorbek", "Hi"));
+
+	std::vector<messenger::profile::event_t> events = messenger::profile::collect();
+
+	std::ostringstream histograms;
+	histograms.precision(4);
+	messenger::profile::write_histograms(histograms, events);
+
+	REQUIRE(histograms.flags() == std::ostringstream().flags());
+	REQUIRE(histograms.precision() == 4);
+
+	REQUIRE(histograms.str().find("crc: 1 events") != std::string::npos);
+
+	std::ostringstream trace;
+	messenger::profile::write_chrome_trace(trace, events);
+
+	REQUIRE(trace.flags() == std::ostringstream().flags());
+
+	REQUIRE(trace.str().rfind("{\"traceEvents\":[", 0) == 0);
+	REQUIRE(trace.str().find("\"name\":\"text_splitter\",\"ph\":\"X\"") != std::string::npos);
+}
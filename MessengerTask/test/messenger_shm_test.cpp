@@ -0,0 +1,252 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "task1_messenger.hpp"
+#include "messenger_shm.hpp"
+
+static std::string channel_name(const std::string& test)
+{
+	return "/messenger_" + test + "_" + std::to_string(getpid());
+}
+
+TEST_CASE("Shm_SendReceive", "Shm")
+{
+	std::string name = channel_name("send_receive");
+
+	messenger::shm_channel producer(name, 4096);
+	messenger::shm_channel consumer(name);
+
+	REQUIRE(consumer.peek().empty());
+
+	producer.send(messenger::msg_t("Elyorbek", "this message contains 62 chars,this message contains 62 chars "));
+	producer.send(messenger::msg_t("E", "Hi"));
+
+	const messenger::msg_t& message1 = consumer.receive();
+	const messenger::msg_t& message2 = consumer.receive();
+
+	REQUIRE(message1.name == "Elyorbek");
+	REQUIRE(message1.text == "this message contains 62 chars,this message contains 62 chars ");
+	REQUIRE(message2.name == "E");
+	REQUIRE(message2.text == "Hi");
+	REQUIRE(consumer.peek().empty());
+}
+
+TEST_CASE("Shm_PeekInPlace", "Shm")
+{
+	std::string name = channel_name("peek");
+
+	messenger::shm_channel producer(name, 4096);
+	messenger::shm_channel consumer(name);
+
+	messenger::msg_t msg("Elyorbek", "Hi");
+	producer.send(msg);
+
+	std::span<const uint8_t> buff = consumer.peek();
+
+	REQUIRE(std::vector<uint8_t>(buff.begin(), buff.end()) == messenger::make_buff(msg));
+
+	consumer.release();
+
+	REQUIRE(consumer.peek().empty());
+}
+
+TEST_CASE("Shm_Full", "Shm")
+{
+	std::string name = channel_name("full");
+
+	messenger::shm_channel producer(name, 64);
+	messenger::shm_channel consumer(name);
+
+	messenger::msg_t msg("Elyorbek", "this message contains 31 chars ");	// one record takes the whole ring
+
+	REQUIRE(producer.try_send(msg) == true);
+	REQUIRE(producer.try_send(msg) == false);
+
+	consumer.receive();
+
+	REQUIRE(producer.try_send(msg) == true);
+	REQUIRE_THROWS_AS(producer.try_send(messenger::msg_t("Elyorbek", std::string(100, 'x'))), std::length_error);
+}
+
+TEST_CASE("Shm_WrapAround", "Shm")
+{
+	std::string name = channel_name("wrap");
+
+	messenger::shm_channel producer(name, 256);
+	messenger::shm_channel consumer(name);
+
+	for (int i = 0; i < 100; i++)
+	{
+		std::string text(1 + i % 40, static_cast<char>('a' + i % 26));
+
+		producer.send(messenger::msg_t("Elyorbek", text));
+
+		REQUIRE(consumer.receive().text == text);
+	}
+}
+
+TEST_CASE("Shm_WrapLargeRecord", "Shm")
+{
+	std::string name = channel_name("wraplarge");
+
+	messenger::shm_channel producer(name, 64);
+	messenger::shm_channel consumer(name);
+
+	producer.send(messenger::msg_t("E", "Hi"));
+	consumer.receive();
+
+	// a 56 byte record at offset 16 does not fit before the end, nor together with the skipped 48 bytes
+	messenger::msg_t msg("Elyorbek", std::string(32, 'x'));
+
+	REQUIRE(producer.try_send(msg) == false);	// publishes the padding only
+
+	consumer.peek();							// skips the padding
+
+	REQUIRE(producer.try_send(msg) == true);
+	REQUIRE(consumer.receive().text == msg.text);
+
+	producer.send(messenger::msg_t("E", "Hi"));
+	consumer.receive();
+
+	std::thread receiver([&]() { consumer.receive(); });
+
+	producer.send(msg);
+	receiver.join();
+}
+
+TEST_CASE("Shm_CorruptedRecord", "Shm")
+{
+	std::string name = channel_name("corrupt");
+
+	messenger::shm_channel producer(name, 64);
+	messenger::shm_channel consumer(name);
+
+	producer.send(messenger::msg_t("Elyorbek", "Hi"));
+
+	// the LEN field precedes the buffer
+	uint8_t* len = const_cast<uint8_t*>(consumer.peek().data()) - sizeof(uint32_t);
+
+	uint32_t too_long = 64;
+	std::memcpy(len, &too_long, sizeof(too_long));
+
+	REQUIRE_THROWS_AS(consumer.peek(), std::runtime_error);
+
+	uint32_t empty = 0;
+	std::memcpy(len, &empty, sizeof(empty));
+
+	REQUIRE_THROWS_AS(consumer.peek(), std::runtime_error);
+}
+
+TEST_CASE("Shm_BlockingThreads", "Shm")
+{
+	std::string name = channel_name("threads");
+
+	messenger::shm_channel producer(name, 256);
+	messenger::shm_channel consumer(name);
+
+	const int count = 10000;
+
+	std::thread sender([&]()
+	{
+		for (int i = 0; i < count; i++)
+		{
+			producer.send(messenger::msg_t("Elyorbek", std::to_string(i)));
+		}
+	});
+
+	bool in_order = true;
+
+	for (int i = 0; i < count; i++)
+	{
+		if (consumer.receive().text != std::to_string(i)) in_order = false;
+	}
+
+	sender.join();
+
+	REQUIRE(in_order == true);
+}
+
+TEST_CASE("Shm_BlockingThreadsSingleRecord", "Shm")
+{
+	std::string name = channel_name("single");
+
+	messenger::shm_channel producer(name, 64);	// every record fills the ring, so each send waits for the previous receive
+	messenger::shm_channel consumer(name);
+
+	const int count = 100000;
+
+	std::thread sender([&]()
+	{
+		for (int i = 0; i < count; i++)
+		{
+			std::string text = std::to_string(i);
+			text.resize(31, '.');
+
+			producer.send(messenger::msg_t("Elyorbek", text));
+		}
+	});
+
+	bool in_order = true;
+
+	for (int i = 0; i < count; i++)
+	{
+		std::string text = std::to_string(i);
+		text.resize(31, '.');
+
+		if (consumer.receive().text != text) in_order = false;
+	}
+
+	sender.join();
+
+	REQUIRE(in_order == true);
+}
+
+TEST_CASE("Shm_CrossProcess", "Shm")
+{
+	std::string name = channel_name("process");
+
+	messenger::shm_channel consumer_end(name, 1024);
+
+	pid_t child = fork();
+
+	if (child == 0)
+	{
+		messenger::shm_channel producer(name);
+
+		for (int i = 0; i < 1000; i++)
+		{
+			producer.send(messenger::msg_t("Timur", "message " + std::to_string(i)));
+		}
+
+		_exit(0);
+	}
+
+	bool in_order = true;
+
+	for (int i = 0; i < 1000; i++)
+	{
+		const messenger::msg_t& message = consumer_end.receive();
+
+		if (message.name != "Timur" || message.text != "message " + std::to_string(i)) in_order = false;
+	}
+
+	int status = 0;
+	waitpid(child, &status, 0);
+
+	REQUIRE(in_order == true);
+	REQUIRE(WIFEXITED(status));
+	REQUIRE(WEXITSTATUS(status) == 0);
+}
+
+TEST_CASE("Shm_OpenMissing", "Shm")
+{
+	REQUIRE_THROWS_AS(messenger::shm_channel(channel_name("missing")), std::system_error);
+}
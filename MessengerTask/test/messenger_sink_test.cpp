@@ -0,0 +1,178 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <deque>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "task1_messenger.hpp"
+#include "messenger_sink.hpp"
+
+struct test_iovec_t
+{
+	void* iov_base;
+	size_t iov_len;
+};
+
+// encodes only through reserve / commit, a copy through write is an error
+struct in_place_sink_t
+{
+	uint8_t area[256];
+	size_t used = 0;
+	size_t reserves = 0;
+
+	uint8_t* reserve(size_t size)
+	{
+		reserves++;
+		return area + used;
+	}
+
+	void commit(size_t size)
+	{
+		used += size;
+	}
+
+	void write(const uint8_t*, size_t)
+	{
+		throw std::logic_error("packet copied through write");
+	}
+};
+
+static_assert(messenger::contiguous_packet_sink<messenger::span_sink>);
+static_assert(messenger::contiguous_packet_sink<messenger::back_insert_sink<std::vector<uint8_t>>>);
+static_assert(messenger::contiguous_packet_sink<messenger::back_insert_sink<std::string>>);
+static_assert(!messenger::contiguous_packet_sink<messenger::back_insert_sink<std::deque<uint8_t>>>);
+static_assert(!messenger::contiguous_packet_sink<messenger::iovec_sink<test_iovec_t>>);
+
+TEST_CASE("MakeBuffSink_Span", "MakeBuffSink")
+{
+	messenger::msg_t msg("Elyorbek", "this message contains 62 chars,this message contains 62 chars ");
+
+	uint8_t area[256];
+	messenger::span_sink sink(area);
+
+	messenger::make_buff(msg, sink);
+
+	REQUIRE(std::vector<uint8_t>(area, area + sink.size()) == messenger::make_buff(msg));
+}
+
+TEST_CASE("MakeBuffSink_SpanTooSmall", "MakeBuffSink")
+{
+	uint8_t area[8];
+	messenger::span_sink sink(area);
+
+	REQUIRE_THROWS_AS(messenger::make_buff(messenger::msg_t("Elyorbek", "Hi"), sink), std::length_error);
+}
+
+TEST_CASE("MakeBuffSink_Pmr", "MakeBuffSink")
+{
+	std::pmr::monotonic_buffer_resource pool;
+	std::pmr::polymorphic_allocator<char> alloc(&pool);
+
+	messenger::basic_msg_t<std::pmr::polymorphic_allocator<char>> msg("ElyorbekElyorbe", "this message contains 32 chars  ", alloc);
+
+	std::pmr::vector<uint8_t> buff(&pool);
+	messenger::back_insert_sink<std::pmr::vector<uint8_t>> sink(buff);
+
+	messenger::make_buff(msg, sink);
+
+	REQUIRE(std::vector<uint8_t>(buff.begin(), buff.end()) == messenger::make_buff(messenger::msg_t("ElyorbekElyorbe", "this message contains 32 chars  ")));
+}
+
+TEST_CASE("MakeBuffSink_Iovec", "MakeBuffSink")
+{
+	messenger::msg_t msg("Elyorbek", "this message contains 62 chars,this message contains 62 chars ");
+
+	uint8_t first[10];
+	uint8_t second[100];
+	test_iovec_t segments[] = { { first, sizeof(first) }, { second, sizeof(second) } };
+
+	messenger::iovec_sink<test_iovec_t> sink(segments);
+
+	messenger::make_buff(msg, sink);
+
+	std::vector<uint8_t> buff(first, first + sizeof(first));
+	buff.insert(buff.end(), second, second + sink.size() - sizeof(first));
+
+	REQUIRE(buff == messenger::make_buff(msg));
+}
+
+TEST_CASE("MakeBuffSink_NameLen16", "MakeBuffSink")
+{
+	std::vector<uint8_t> buff;
+	messenger::back_insert_sink<std::vector<uint8_t>> sink(buff);
+
+	REQUIRE_THROWS_AS(messenger::make_buff(messenger::msg_t("ElyorbekElyorbek", "Hi"), sink), std::length_error);
+}
+
+TEST_CASE("ParseBuffSpan_Pmr", "ParseBuffSpan")
+{
+	std::string text("this message contains 62 chars,this message contains 62 chars ");
+	const std::vector<uint8_t> buff = messenger::make_buff(messenger::msg_t("Elyorbek", text));
+
+	std::pmr::monotonic_buffer_resource pool;
+	std::pmr::polymorphic_allocator<char> alloc(&pool);
+
+	auto msg = messenger::parse_buff(std::span<const uint8_t>(buff), alloc);
+
+	REQUIRE(msg.name == "Elyorbek");
+	REQUIRE(std::string_view(msg.text) == text);
+	REQUIRE(msg.text.get_allocator() == alloc);
+}
+
+TEST_CASE("ParseBuffSpan_Compressed", "ParseBuffSpan")
+{
+	std::string text(300, 'q');
+	const std::vector<uint8_t> buff = messenger::make_compressed_buff(messenger::msg_t("Elyorbek", text));
+
+	messenger::msg_t msg = messenger::parse_buff(std::span<const uint8_t>(buff));
+
+	REQUIRE(msg.text == text);
+}
+
+TEST_CASE("ParseBuffSpan_WrongCRC", "ParseBuffSpan")
+{
+	std::vector<uint8_t> buff = messenger::make_buff(messenger::msg_t("Elyorbek", "Hi"));
+
+	buff[1] &= 0xf0; // clear crc field
+
+	REQUIRE_THROWS_AS(messenger::parse_buff(std::span<const uint8_t>(buff)), std::runtime_error);
+}
+
+TEST_CASE("ParseBuffSpan_Truncated", "ParseBuffSpan")
+{
+	std::vector<uint8_t> buff = messenger::make_buff(messenger::msg_t("Elyorbek", "Hi"));
+
+	buff.pop_back();
+
+	REQUIRE_THROWS_AS(messenger::parse_buff(std::span<const uint8_t>(buff)), std::runtime_error);
+}
+
+TEST_CASE("MakeBuffSink_InPlace", "MakeBuffSink")
+{
+	messenger::msg_t msg("Elyorbek", "this message contains 62 chars,this message contains 62 chars ");
+
+	in_place_sink_t sink;
+
+	messenger::make_buff(msg, sink);
+
+	REQUIRE(sink.reserves == 2);	// one per packet
+	REQUIRE(std::vector<uint8_t>(sink.area, sink.area + sink.used) == messenger::make_buff(msg));
+}
+
+TEST_CASE("MakeBuffSink_BackInsertInvalid", "MakeBuffSink")
+{
+	std::vector<uint8_t> buff{ 1, 2, 3 };
+	messenger::back_insert_sink<std::vector<uint8_t>> sink(buff);
+
+	REQUIRE_THROWS_AS(messenger::make_buff(messenger::msg_t("ElyorbekElyorbek", "Hi"), sink), std::length_error);
+	REQUIRE(buff == std::vector<uint8_t>{ 1, 2, 3 });	// checked before any memory is reserved
+
+	std::deque<uint8_t> queue;
+	messenger::back_insert_sink<std::deque<uint8_t>> queue_sink(queue);
+
+	messenger::make_buff(messenger::msg_t("Elyorbek", "Hi"), queue_sink);
+
+	REQUIRE(std::vector<uint8_t>(queue.begin(), queue.end()) == messenger::make_buff(messenger::msg_t("Elyorbek", "Hi")));
+}
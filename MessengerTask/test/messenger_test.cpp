@@ -402,4 +402,207 @@ TEST_CASE("ParseBuff_MsgLen62", "ParseBuff")
 
 	REQUIRE(message.name == name);
 	REQUIRE(message.text == text);
-}
\ No newline at end of file
+}
+
+TEST_CASE("ParseBuff_MsgLen500", "ParseBuff") 
+{
+	std::string name("Elyorbek");
+	std::string text(500, 'x');
+
+	std::vector<uint8_t> buff = messenger::make_buff(messenger::msg_t(name, text));
+
+	REQUIRE(buff.size() == 17 * (HEADER_SIZE + name.size()) + text.size());
+
+	const messenger::msg_t& message = messenger::parse_buff(buff);
+
+	REQUIRE(message.name == name);
+	REQUIRE(message.text == text);
+}
+
+TEST_CASE("ParseBatch_Columns", "ParseBatch") 
+{
+	std::string name1("Elyorbek");
+	std::string text1("this message contains 62 chars,this message contains 62 chars ");
+
+	std::string name2("E");
+	std::string text2("Hi");
+
+	std::vector<std::vector<uint8_t>> buffs;
+	buffs.push_back(messenger::make_buff(messenger::msg_t(name1, text1)));
+	buffs.push_back(messenger::make_buff(messenger::msg_t(name2, text2)));
+
+	const messenger::msg_batch_t& batch = messenger::parse_batch(buffs);
+
+	REQUIRE(batch.size() == 2);
+
+	REQUIRE(batch.name_offsets == std::vector<uint32_t>{ 0, 8, 9 });
+	REQUIRE(batch.text_offsets == std::vector<uint32_t>{ 0, 62, 64 });
+	REQUIRE(batch.name_lens == std::vector<uint8_t>{ 8, 1 });
+	REQUIRE(batch.packet_counts == std::vector<uint32_t>{ 2, 1 });
+
+	REQUIRE(std::string(batch.names.begin(), batch.names.end()) == name1 + name2);
+	REQUIRE(std::string(batch.texts.begin(), batch.texts.end()) == text1 + text2);
+}
+
+TEST_CASE("ParseBatch_Empty", "ParseBatch") 
+{
+	std::vector<std::vector<uint8_t>> buffs;
+
+	const messenger::msg_batch_t& batch = messenger::parse_batch(buffs);
+
+	REQUIRE(batch.size() == 0);
+	REQUIRE(batch.name_offsets == std::vector<uint32_t>{ 0 });
+	REQUIRE(batch.text_offsets == std::vector<uint32_t>{ 0 });
+}
+
+TEST_CASE("ParseBatch_WrongCRC", "ParseBatch") 
+{
+	std::vector<std::vector<uint8_t>> buffs;
+	buffs.push_back(messenger::make_buff(messenger::msg_t("Elyorbek", "Hi")));
+	buffs.push_back(messenger::make_buff(messenger::msg_t("Timur", "Hi")));
+
+	buffs[1][1] &= 0xf0; // clear crc field
+
+	bool caught_error = false;
+
+	try 
+	{
+		const messenger::msg_batch_t& batch = messenger::parse_batch(buffs);
+	}
+	catch (const std::runtime_error& error) 
+	{
+		caught_error = true;
+	}
+
+	REQUIRE(caught_error == true);
+}
+
+TEST_CASE("ParseBatch_Truncated", "ParseBatch") 
+{
+	std::vector<std::vector<uint8_t>> buffs;
+	buffs.push_back(messenger::make_buff(messenger::msg_t("Elyorbek", "Hi")));
+
+	buffs[0].pop_back();
+
+	bool caught_error = false;
+
+	try 
+	{
+		const messenger::msg_batch_t& batch = messenger::parse_batch(buffs);
+	}
+	catch (const std::runtime_error& error) 
+	{
+		caught_error = true;
+	}
+
+	REQUIRE(caught_error == true);
+}
+
+TEST_CASE("MakeCompressedBuff_Flag", "MakeCompressedBuff") 
+{
+	std::string name("Elyorbek");
+	std::string text;
+
+	for (int i = 0; i < 20; i++)
+	{
+		text += "link is up, link is up, ";
+	}
+
+	const std::vector<uint8_t>& buff = messenger::make_compressed_buff(messenger::msg_t(name, text));
+	const std::vector<uint8_t>& plain_buff = messenger::make_buff(messenger::msg_t(name, text));
+
+	REQUIRE(buff.size() < plain_buff.size());
+	REQUIRE((buff[0] >> (__CHAR_BIT__ - FLAG_LEN)) == 0b110);
+}
+
+TEST_CASE("MakeCompressedBuff_Incompressible", "MakeCompressedBuff") 
+{
+	std::string name("Elyorbek");
+	std::string text("Hi");
+
+	REQUIRE(messenger::make_compressed_buff(messenger::msg_t(name, text)) == messenger::make_buff(messenger::msg_t(name, text)));
+}
+
+TEST_CASE("MakeCompressedBuff_MsgLen0", "MakeCompressedBuff") 
+{
+	bool caught_error = false;
+
+	try
+	{
+		const std::vector<uint8_t>& buff = messenger::make_compressed_buff(messenger::msg_t("Elyorbek", ""));
+	}
+	catch (const std::length_error& error) 
+	{
+		caught_error = true;
+	}
+
+	REQUIRE(caught_error == true);
+}
+
+TEST_CASE("ParseBuff_Compressed", "ParseBuff") 
+{
+	std::string name("Elyorbek");
+	std::string text;
+
+	for (int i = 0; i < 100; i++)
+	{
+		text += "sync record " + std::to_string(i % 10) + " unchanged; ";
+	}
+
+	std::vector<uint8_t> buff = messenger::make_compressed_buff(messenger::msg_t(name, text));
+
+	const messenger::msg_t& message = messenger::parse_buff(buff);
+
+	REQUIRE(message.name == name);
+	REQUIRE(message.text == text);
+}
+
+TEST_CASE("ParseBatch_CompressedMsgLen0", "ParseBatch") 
+{
+	std::vector<uint8_t> buff{ 0b11000010, 0b00000000, 'E' };	// compressed flag, NAME_LEN 1, MSG_LEN 0
+
+	buff[1] |= CRC::Calculate(static_cast<void*>(&buff[0]), buff.size(), CRC::CRC_4_ITU()); // set crc value
+
+	std::vector<std::vector<uint8_t>> buffs{ buff };
+
+	bool caught_error = false;
+
+	try 
+	{
+		const messenger::msg_batch_t& batch = messenger::parse_batch(buffs);
+	}
+	catch (const std::runtime_error& error) 
+	{
+		caught_error = true;
+	}
+
+	REQUIRE(caught_error == true);
+}
+
+TEST_CASE("ParseBatch_Compressed", "ParseBatch") 
+{
+	std::string text(500, 'z');
+
+	std::vector<std::vector<uint8_t>> buffs;
+	buffs.push_back(messenger::make_compressed_buff(messenger::msg_t("Elyorbek", text)));
+	buffs.push_back(messenger::make_buff(messenger::msg_t("Timur", "Hi")));
+
+	const messenger::msg_batch_t& batch = messenger::parse_batch(buffs);
+
+	REQUIRE(batch.text_offsets == std::vector<uint32_t>{ 0, 500, 502 });
+	REQUIRE(std::string(batch.texts.begin(), batch.texts.end()) == text + "Hi");
+}
+
+TEST_CASE("ParseBatch_InputUnmodified", "ParseBatch") 
+{
+	std::vector<std::vector<uint8_t>> buffs;
+	buffs.push_back(messenger::make_buff(messenger::msg_t("Elyorbek", "this message contains 32 chars  ")));
+	buffs.push_back(messenger::make_compressed_buff(messenger::msg_t("Timur", std::string(100, 'z'))));
+
+	const std::vector<std::vector<uint8_t>> buffs_cpy = buffs;
+
+	const messenger::msg_batch_t& batch = messenger::parse_batch(buffs);
+
+	REQUIRE(batch.size() == 2);
+	REQUIRE(buffs == buffs_cpy);
+}
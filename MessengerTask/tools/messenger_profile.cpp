@@ -0,0 +1,48 @@
+// messenger_profile.cpp : Runs an encode / decode workload and dumps the per-stage timings.
+//
+// usage: messenger_profile [iterations] [trace.json]
+//
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "task1_messenger.hpp"
+#include "messenger_profile.hpp"
+
+int main(int argc, char* argv[])
+{
+	int iterations = argc > 1 ? std::atoi(argv[1]) : 10000;
+
+	std::vector<messenger::msg_t> msgs = {
+		messenger::msg_t("E", "Hi"),
+		messenger::msg_t("Elyorbek", "this message contains 31 chars "),
+		messenger::msg_t("ElyorbekElyorbe", std::string(500, 'x')),
+	};
+
+	messenger::profile::reset();
+
+	for (int i = 0; i < iterations; i++)
+	{
+		for (const messenger::msg_t& msg : msgs)
+		{
+			std::vector<uint8_t> buff = messenger::make_buff(msg);
+			messenger::parse_buff(buff);
+		}
+	}
+
+	std::vector<messenger::profile::event_t> events = messenger::profile::collect();
+
+	messenger::profile::write_histograms(std::cout, events);
+
+	if (argc > 2)
+	{
+		std::ofstream trace(argv[2]);
+		messenger::profile::write_chrome_trace(trace, events);
+
+		std::cout << "chrome trace written to " << argv[2] << "\n";
+	}
+
+	return 0;
+}
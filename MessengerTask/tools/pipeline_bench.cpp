@@ -0,0 +1,95 @@
+// pipeline_bench.cpp : Compares receive throughput of parse_buff calls (vector and span) and receive_pipeline.
+//
+// usage: messenger_pipeline_bench [messages]
+//
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "task1_messenger.hpp"
+#include "messenger_pipeline.hpp"
+
+static std::vector<std::vector<uint8_t>> make_buffs(int count)
+{
+	std::vector<std::vector<uint8_t>> buffs;
+	buffs.reserve(count);
+
+	for (int i = 0; i < count; i++)
+	{
+		std::string text = "message " + std::to_string(i) + " " + std::string(i % 300, 'x');
+		buffs.push_back(messenger::make_buff(messenger::msg_t("Elyorbek", text)));
+	}
+
+	return buffs;
+}
+
+static void report(const char* name, int count, std::chrono::steady_clock::duration elapsed)
+{
+	double seconds = std::chrono::duration<double>(elapsed).count();
+
+	std::cout << name << ": " << count << " messages in " << seconds * 1000 << " ms, "
+		<< count / seconds / 1e6 << " M msg/s\n";
+}
+
+int main(int argc, char* argv[])
+{
+	int count = argc > 1 ? std::atoi(argv[1]) : 1000000;
+
+	size_t checksum = 0;
+
+	{
+		std::vector<std::vector<uint8_t>> buffs = make_buffs(count);
+
+		auto start = std::chrono::steady_clock::now();
+
+		for (std::vector<uint8_t>& buff : buffs)
+		{
+			checksum += messenger::parse_buff(buff).text.size();
+		}
+
+		report("parse_buff", count, std::chrono::steady_clock::now() - start);
+	}
+
+	{
+		// same single-threaded decode the pipeline stages share, without the queues
+		std::vector<std::vector<uint8_t>> buffs = make_buffs(count);
+
+		auto start = std::chrono::steady_clock::now();
+
+		for (const std::vector<uint8_t>& buff : buffs)
+		{
+			checksum += messenger::parse_buff(std::span<const uint8_t>(buff)).text.size();
+		}
+
+		report("parse_buff(span)", count, std::chrono::steady_clock::now() - start);
+	}
+
+	for (size_t batch_size : { 1, 32, 256 })
+	{
+		std::vector<std::vector<uint8_t>> buffs = make_buffs(count);
+
+		messenger::pipeline_config_t config;
+		config.batch_size = batch_size;
+
+		auto start = std::chrono::steady_clock::now();
+
+		messenger::receive_pipeline pipeline([&](const messenger::msg_t& msg) { checksum += msg.text.size(); }, nullptr, config);
+
+		for (std::vector<uint8_t>& buff : buffs)
+		{
+			pipeline.push(std::move(buff));
+		}
+
+		pipeline.finish();
+
+		std::string name = "receive_pipeline, batch " + std::to_string(batch_size);
+		report(name.c_str(), count, std::chrono::steady_clock::now() - start);
+	}
+
+	std::cout << "checksum " << checksum << "\n";
+
+	return 0;
+}